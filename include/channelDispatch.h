@@ -0,0 +1,90 @@
+/*
+ * File: include/channelDispatch.h
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+// Binds a network channel to the function decoding and handling its packets.
+// Every channel of a receiver needs a specialization, otherwise building the
+// dispatch table fails.
+template <class Receiver, int Channel>
+struct channelBinding {
+  static_assert(Channel < 0, "Network channel has no packet handler bound");
+};
+
+template <int... Channels>
+struct channelSequence {
+};
+
+template <int Count, int... Channels>
+struct makeChannelSequence : makeChannelSequence<Count - 1, Count - 1, Channels...> {
+};
+
+template <int... Channels>
+struct makeChannelSequence<0, Channels...> {
+  typedef channelSequence<Channels...> type;
+};
+
+template <class Receiver, class Sequence>
+struct channelTable;
+
+// constant table with one dispatch function per channel, indexed by channel id
+template <class Receiver, int... Channels>
+struct channelTable<Receiver, channelSequence<Channels...>> {
+  typedef void (*handler_t)(Receiver *receiver, const void *data, size_t length);
+
+  static const handler_t handlers[sizeof...(Channels)];
+};
+
+template <class Receiver, int... Channels>
+const typename channelTable<Receiver, channelSequence<Channels...>>::handler_t channelTable<Receiver, channelSequence<Channels...>>::handlers[sizeof...(Channels)] = {
+  &channelBinding<Receiver, Channels>::dispatch...
+};
+
+template <class Receiver, int ChannelCount>
+inline void dispatchChannel(Receiver *receiver, int channelId, const void *data, size_t length) {
+  channelTable<Receiver, typename makeChannelSequence<ChannelCount>::type>::handlers[channelId](receiver, data, length);
+}
+
+// bind a channel to a packet type and receiver method taking the decoded packet
+#define BIND_CHANNEL(RECEIVER, CHANNEL, PACKET, HANDLER) \
+  template <> \
+  struct channelBinding<RECEIVER, CHANNEL> { \
+    static void dispatch(RECEIVER *receiver, const void *data, size_t length) { \
+      receiver->dispatchPacket<PACKET, &RECEIVER::HANDLER>(data, length, #PACKET); \
+    } \
+  }
+
+// bind a channel which is never expected to receive packets
+#define IGNORE_CHANNEL(RECEIVER, CHANNEL) \
+  template <> \
+  struct channelBinding<RECEIVER, CHANNEL> { \
+    static void dispatch(RECEIVER *receiver, const void *, size_t) { \
+      receiver->unexpectedPacket(CHANNEL); \
+    } \
+  }
@@ -31,57 +31,270 @@
 
 #include <string>
 #include <thread>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <unordered_map>
 
 #include "protocol.h"
+#include "channelDispatch.h"
+#include "networkWakeup.h"
+#include "commandQueue.h"
+#include "teamspeakUpdater.h"
+#include "config.h"
+
+#define POSITION_KEYFRAME_HISTORY 4
+
+#define CLIENT_COMMAND_QUEUE_SIZE 256
+
+// longest time to wait for the voice server to accept the connection (in ms)
+#define CLIENT_CONNECT_TIMEOUT 5000
+
+// longest time to wait for the voice server to confirm a disconnect (in ms)
+#define CLIENT_DISCONNECT_TIMEOUT 500
+
+// time without acknowledgements until the connection counts as lost (in ms)
+#define CLIENT_PEER_TIMEOUT_MINIMUM 3000
+#define CLIENT_PEER_TIMEOUT_MAXIMUM 10000
+
+// delay before the first attempt to resume a lost session, doubled for each further attempt (in ms)
+#define CLIENT_RECONNECT_DELAY 250
+#define CLIENT_RECONNECT_MAX_DELAY 8000
+#define CLIENT_RECONNECT_ATTEMPTS 8
+
+// longest time to wait for teamspeak to confirm a step of joining the in-game channel (in ms)
+#define CLIENT_JOIN_STEP_TIMEOUT 2000
+
+// shortest time between two status messages (in ms)
+#define CLIENT_STATUS_INTERVAL 50
+
+typedef enum {
+  CLIENT_COMMAND_STATUS,
+  CLIENT_COMMAND_CONNECT,
+  CLIENT_COMMAND_DISCONNECT,
+  CLIENT_COMMAND_OWN_CLIENT_MOVED
+} clientCommandType_t;
+
+// work handed from teamspeak and http threads to the network thread
+typedef struct {
+  clientCommandType_t type;
+  uint64_t value;
+  bool talking;
+  bool microphoneMuted;
+  bool speakersMuted;
+} clientCommand_t;
+
+// connection states in the order they are passed while joining
+typedef enum {
+  CLIENT_STATE_DISCONNECTED,
+  CLIENT_STATE_RESOLVING,
+  CLIENT_STATE_CONNECTING,
+  CLIENT_STATE_PROTOCOL,
+  CLIENT_STATE_HANDSHAKE,
+  CLIENT_STATE_INGAME
+} clientState_t;
+
+// connection values reported by the stats output, taken on the network thread
+typedef struct {
+  clientState_t state;
+  uint32_t capabilities;
+  uint64_t rejectedPackets;
+  uint32_t reconnectAttempts;
+
+  uint32_t roundTripTime;
+  uint32_t packetLoss;
+  uint32_t mtu;
+  uint32_t incomingBandwidth;
+  uint32_t outgoingBandwidth;
+  uint32_t throttleInterval;
+  uint32_t throttleAcceleration;
+  uint32_t throttleDeceleration;
+  uint32_t timeoutLimit;
+  uint32_t timeoutMinimum;
+  uint32_t timeoutMaximum;
+  uint32_t pingInterval;
+
+  uint32_t sentPackets;
+  uint32_t receivedPackets;
+  uint32_t sentBytes;
+  uint32_t receivedBytes;
+
+  uint64_t appliedPositions;
+  uint64_t skippedPositions;
+} clientStats_t;
+
+// teamspeak events awaited while joining the in-game channel
+typedef enum {
+  CLIENT_JOIN_NONE,
+  CLIENT_JOIN_MUTING_OUTPUT,
+  CLIENT_JOIN_MOVING
+} clientJoinStep_t;
+
+typedef std::unordered_map<uint16_t, clientPositionUpdate_t> positionTable_t;
 
 class Client {
+  template <class Receiver, int Channel>
+  friend struct channelBinding;
+
 private:
   ENetHost *_client;
   ENetPeer *_peer;
+  clientConfig_t _config;
 
   std::thread *_thread;
-  bool _running;
+  std::atomic<bool> _running;
+
+  std::atomic<clientState_t> _state;
+  std::mutex _stateMutex;
+  std::condition_variable _stateCondition;
+  std::string _targetHost;
+  uint16_t _targetPort;
+  uint16_t _targetGameId;
+  bool _connectRequested;
+  bool _disconnectRequested;
+  std::chrono::steady_clock::time_point _connectTime;
+  std::atomic<bool> _disconnecting;
+  std::atomic<uint32_t> _disconnectTimeout;
+  std::chrono::steady_clock::time_point _disconnectTime;
+
+  clientJoinStep_t _joinStep;
+  std::chrono::steady_clock::time_point _joinStepTime;
+  uint64_t _joinChannelId;
+  std::string _joinChannelPassword;
+  uint64_t _joinLastChannelId;
+  bool _joinTempMute;
+
+  std::string _resumptionToken;
+  std::atomic<bool> _reconnecting;
+  uint32_t _reconnectAttempts;
+  std::chrono::steady_clock::time_point _reconnectTime;
+  enet_uint32 _lastPeerActivity;
+
   uint16_t _gameId;
   uint16_t _teamspeakId;
   std::string _host;
   uint16_t _port;
   uint64_t _lastChannelId;
+  uint32_t _capabilities;
+  void *_rangeCoder;
+  bool _compressOutgoing;
+
+  std::atomic<bool> _talking;
+  std::atomic<bool> _microphoneMuted;
+  std::atomic<bool> _speakersMuted;
+
+  std::deque<std::pair<uint16_t, positionTable_t>> _positionKeyframes;
+  positionTable_t _positionTable;
+
+  std::atomic<uint64_t> _rejectedPackets;
+
+  TeamspeakUpdater _updater;
 
-  bool _talking;
-  bool _microphoneMuted;
-  bool _speakersMuted;
+  std::mutex _statsMutex;
+  clientStats_t _stats;
+
+  std::vector<std::pair<int, ENetPacket *>> _pendingPackets;
+  NetworkWakeup _wakeup;
+
+  CommandQueue<clientCommand_t, CLIENT_COMMAND_QUEUE_SIZE> _commands;
+  std::atomic<bool> _droppedCommands;
+
+  std::atomic<uint32_t> _statusInterval;
+  statusPacket_t _pendingStatus;
+  bool _hasPendingStatus;
+  statusPacket_t _sentStatus;
+  bool _hasSentStatus;
+  std::chrono::steady_clock::time_point _statusSentTime;
 
 public:
-  Client();
+  Client(clientConfig_t config);
   virtual ~Client();
 
   bool connect(std::string host, uint16_t port, uint16_t uniqueIdentifier);
-  void disconnect(uint32_t status = DISCONNECT_STATUS_OK);
+  bool disconnect(uint32_t status = DISCONNECT_STATUS_OK);
   bool isOpen() const;
   bool isIngame() const;
+  clientState_t state() const;
+  bool waitForState(clientState_t state, uint32_t timeout);
 
+  void ownClientMoved(uint64_t channelId);
+  void forgetClient(anyID clientId);
   void setTalking(bool talking);
   void setMicrophoneMuted(bool muted);
   void setSpeakersMuted(bool muted);
   bool isTalking() const;
   bool hasMicrophoneMuted() const;
   bool hasSpeakersMuted() const;
+  void setDisconnectTimeout(uint32_t milliseconds);
+  uint32_t disconnectTimeout() const;
+  void setStatusInterval(uint32_t milliseconds);
+  uint32_t statusInterval() const;
+  bool hasCapability(uint32_t capability) const;
+  uint64_t rejectedPackets() const;
+  clientConfig_t config() const;
+  clientStats_t stats();
 
 private:
   void close();
+  void destroyHost();
+  void resetSession();
+  void resetTeamspeak();
   void update();
   void abortThread();
 
+  void setState(clientState_t state);
+  void startConnection();
+  bool openConnection();
+  void connectionLost();
+  bool isTimeout(ENetEvent &event) const;
+  void updateStats();
+  void startDisconnect(uint32_t status);
+  void updateConnection();
+
+  bool enableCompression();
   void sendProtocolMessage();
   void sendHandshake(int statusCode = STATUS_CODE_OK);
   void sendStatus();
+  void sendStatus(bool talking, bool microphoneMuted, bool speakersMuted);
+  void queueStatus(bool talking, bool microphoneMuted, bool speakersMuted);
+  uint32_t updateStatus();
+  void sendPositionFrameAck(uint16_t keyframe);
 
   void handleMessage(ENetEvent &event);
-  void handleProtocolResponse(ENetPacket *packet);
-  void handleHandshakeResponse(ENetPacket *packet);
-  void handleUpdateMessage(ENetPacket *packet);
-  void handleControlMessage(ENetPacket *packet);
-  void handlePositionMessage(ENetPacket *packet);
+  void handleMessage(int channelId, const void *data, size_t length);
+
+  template <class T, void (Client::*handler)(T &)>
+  void dispatchPacket(const void *data, size_t length, const char *packetName);
+  void unexpectedPacket(int channelId);
+
+  void handleProtocolResponse(protocolResponsePacket_t &protocolPacket);
+  void handleHandshakeResponse(handshakeResponsePacket_t &responsePacket);
+  void resumeSession(handshakeResponsePacket_t &responsePacket);
+  void setJoinStep(clientJoinStep_t step);
+  void moveToJoinChannel();
+  void finishJoin();
+  void abortJoin(int statusCode);
+  void updateJoin();
+  void handleUpdateMessage(updatePacket_t &updatePacket);
+  void handleControlMessage(controlPacket_t &controlPacket);
+  void handlePositionMessage(positionPacket_t &positionPacket);
+  void handlePositionFrameMessage(positionFramePacket_t &framePacket);
+  void handleBatchMessage(batchPacket_t &batchPacket);
+  void applyPositionFrame(positionTable_t &positions, positionFramePacket_t &framePacket);
+  void setPositions(const std::vector<clientPositionUpdate_t> &positions);
+
+  bool postCommand(clientCommandType_t type, uint64_t value = 0);
+  void postStatus();
+  void handleCommands();
+
+  void sendPacket(ENetPacket *packet, int channelId);
+  void sendPacketNow(ENetPacket *packet, int channelId);
+  void flushPackets();
+  void discardPendingPackets();
 
-  void sendPacket(void *data, size_t length, int channelId, bool reliable = true);
+  static size_t ENET_CALLBACK compress(void *context, const ENetBuffer *inBuffers, size_t inBufferCount, size_t inLimit, enet_uint8 *outData, size_t outLimit);
+  static size_t ENET_CALLBACK decompress(void *context, const enet_uint8 *inData, size_t inLimit, enet_uint8 *outData, size_t outLimit);
 };
@@ -0,0 +1,114 @@
+/*
+ * File: include/commandQueue.h
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// Bounded queue for many producing threads and a single consuming thread.
+// Every cell carries a sequence number telling whether it is free for the
+// producer of a position or filled for the consumer, so neither side ever
+// takes a lock or waits. Pushing to a full queue fails instead of blocking.
+template <class T, size_t Capacity>
+class CommandQueue {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of two");
+
+private:
+  typedef struct {
+    std::atomic<size_t> sequence;
+    T value;
+  } cell_t;
+
+  cell_t _cells[Capacity];
+  std::atomic<size_t> _enqueuePosition;
+  std::atomic<size_t> _dequeuePosition;
+
+public:
+  CommandQueue() {
+    for (size_t i = 0; i < Capacity; i++) {
+      _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    _enqueuePosition.store(0, std::memory_order_relaxed);
+    _dequeuePosition.store(0, std::memory_order_relaxed);
+  }
+
+  CommandQueue(const CommandQueue &) = delete;
+  CommandQueue &operator=(const CommandQueue &) = delete;
+
+  // can be called from any thread
+  bool push(const T &value) {
+    size_t position = _enqueuePosition.load(std::memory_order_relaxed);
+    cell_t *cell;
+
+    while (true) {
+      cell = &_cells[position & (Capacity - 1)];
+      size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+      if (difference == 0) {
+        // cell is free, try to claim the position
+        if (_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (difference < 0) {
+        // consumer did not free this cell yet, queue is full
+        return false;
+      } else {
+        // another producer claimed the position first
+        position = _enqueuePosition.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->value = value;
+    cell->sequence.store(position + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  // must only be called from the consuming thread
+  bool pop(T &value) {
+    size_t position = _dequeuePosition.load(std::memory_order_relaxed);
+    cell_t *cell = &_cells[position & (Capacity - 1)];
+
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    if ((intptr_t)sequence - (intptr_t)(position + 1) < 0) {
+      // queue is empty or the producer of this cell is not done yet
+      return false;
+    }
+
+    value = cell->value;
+    _dequeuePosition.store(position + 1, std::memory_order_relaxed);
+
+    // free the cell for the producer one lap later
+    cell->sequence.store(position + Capacity, std::memory_order_release);
+
+    return true;
+  }
+};
@@ -0,0 +1,58 @@
+/*
+ * File: include/config.h
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <string>
+#include <stdint.h>
+
+#define CONFIG_FILE_NAME "JustAnotherVoiceChat.ini"
+
+// settings read from the plugin config file, zero bandwidths are unlimited
+typedef struct {
+  uint32_t incomingBandwidth;
+  uint32_t outgoingBandwidth;
+  uint32_t mtu;
+
+  uint32_t throttleInterval;
+  uint32_t throttleAcceleration;
+  uint32_t throttleDeceleration;
+
+  uint32_t timeoutLimit;
+  uint32_t timeoutMinimum;
+  uint32_t timeoutMaximum;
+  uint32_t pingInterval;
+
+  uint32_t connectTimeout;
+  uint32_t disconnectTimeout;
+  uint32_t statusInterval;
+  uint32_t positionEpsilon;
+} clientConfig_t;
+
+clientConfig_t config_defaults();
+bool config_load(std::string path, clientConfig_t *config);
+std::string config_toString(const clientConfig_t &config);
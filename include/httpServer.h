@@ -30,6 +30,9 @@
 #include <string>
 #include <microhttpd.h>
 
+// longest time a connect request waits for the voice server (in ms)
+#define HTTP_CONNECT_TIMEOUT 5000
+
 class HttpServer {
 private:
   struct MHD_Daemon *_daemon;
@@ -44,7 +47,9 @@ public:
 
 private:
   int handleRequest(struct MHD_Connection *connection, const char *url, const char *method, const char *uploadData, size_t *uploadDataSize);
+  int handleStatsRequest(struct MHD_Connection *connection);
   int sendResponse(struct MHD_Connection *connection, const char *content, unsigned int statusCode = MHD_HTTP_OK);
+  int sendResponse(struct MHD_Connection *connection, const std::string &content, const char *contentType, unsigned int statusCode = MHD_HTTP_OK);
 
   static int requestHandler(void *cls, struct MHD_Connection *connection, const char *url, const char *method, const char *version, const char *uploadData, size_t *uploadDataSize, void **ptr);
 };
@@ -35,8 +35,16 @@ void JustAnotherVoiceChat_stop();
 
 bool JustAnotherVoiceChat_connect(std::string host, uint16_t port, uint16_t uniqueIdentifier);
 
+bool JustAnotherVoiceChat_waitForConnection(uint32_t timeout);
+
+bool JustAnotherVoiceChat_isConnecting();
+
 void JustAnotherVoiceChat_disconnect();
 
+void JustAnotherVoiceChat_ownClientMoved(uint64_t channelId);
+
+void JustAnotherVoiceChat_forgetClient(uint16_t clientId);
+
 void JustAnotherVoiceChat_updateTalking(bool talking);
 
 void JustAnotherVoiceChat_updateMicrophoneMute(bool muted);
@@ -44,3 +52,5 @@ void JustAnotherVoiceChat_updateMicrophoneMute(bool muted);
 void JustAnotherVoiceChat_updateSpeakersMute(bool muted);
 
 bool JustAnotherVoiceChat_isIngame();
+
+std::string JustAnotherVoiceChat_stats();
@@ -0,0 +1,88 @@
+/*
+ * File: include/motionModel.h
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <stddef.h>
+
+// longest delay rendering positions behind the latest sample to interpolate (in ms)
+#define MOTION_MAX_INTERPOLATION_DELAY 200
+
+// longest time positions are extrapolated past the latest sample, clients
+// which stopped moving overshoot by at most this duration (in ms)
+#define MOTION_MAX_EXTRAPOLATION 100
+
+// time to return from the extrapolated position to the latest sample, only
+// moving clients send samples, so one which stopped stays at its last one (in ms)
+#define MOTION_RETURN_DURATION 100
+
+// faster steps between samples are jumps like teleports and respawns which
+// are applied right away instead of being smoothed (in m/s)
+#define MOTION_MAX_SPEED 150
+
+// samples arriving closer to each other replace the latest one (in ms)
+#define MOTION_MIN_SAMPLE_INTERVAL 5
+
+typedef struct {
+  float x;
+  float y;
+  float z;
+} clientPosition_t;
+
+typedef std::chrono::steady_clock::time_point motionTime_t;
+
+// Motion of a single client estimated from its position samples. A new
+// sample is approached from the currently rendered position over one sample
+// interval, so positions move smoothly between samples, and the velocity
+// between the last samples continues the motion for a short time if samples
+// stop arriving. Afterwards the position returns to the latest sample.
+class MotionModel {
+private:
+  clientPosition_t _start;
+  clientPosition_t _latest;
+  motionTime_t _latestTime;
+  clientPosition_t _velocity;
+  double _delay;
+  bool _hasSample;
+
+  clientPosition_t _rendered;
+  bool _hasRendered;
+
+public:
+  MotionModel();
+
+  void addSample(motionTime_t time, const clientPosition_t &position);
+  clientPosition_t positionAt(motionTime_t time) const;
+  bool isSettled(motionTime_t time) const;
+
+  // returns true if the position changed since it was rendered last
+  bool render(motionTime_t time, clientPosition_t *position);
+
+private:
+  void reset(const clientPosition_t &position, motionTime_t time);
+};
@@ -0,0 +1,63 @@
+/*
+ * File: include/networkWakeup.h
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <enet/enet.h>
+
+#include <stdint.h>
+
+// longest time the network thread sleeps without servicing ENet (in ms)
+#define NETWORK_SERVICE_TIMEOUT 100
+
+// timeout to sleep until signaled, only used without an ENet socket
+#define NETWORK_WAIT_INFINITE UINT32_MAX
+
+// Lets the network thread sleep on its ENet socket and be woken up by other
+// threads. Uses a loopback datagram socket sending to itself, which works with
+// ENet's socket set on every platform.
+class NetworkWakeup {
+private:
+  ENetSocket _socket;
+  ENetAddress _address;
+
+public:
+  NetworkWakeup();
+  virtual ~NetworkWakeup();
+
+  bool open();
+  void close();
+  bool isOpen() const;
+
+  void signal();
+
+  // socket can be ENET_SOCKET_NULL to only wait for signals
+  bool wait(ENetSocket socket, uint32_t timeout);
+
+private:
+  void drain();
+};
@@ -0,0 +1,233 @@
+/*
+ * File: include/packetArchive.h
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cereal/cereal.hpp>
+
+#include <stdint.h>
+#include <string.h>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+// Binary output archive only counting the bytes a packet is going to take,
+// used to allocate the network packet with its final size up front.
+class PacketSizeArchive : public cereal::OutputArchive<PacketSizeArchive, cereal::AllowEmptyClassElision> {
+private:
+  size_t _size;
+
+public:
+  PacketSizeArchive() :
+    cereal::OutputArchive<PacketSizeArchive, cereal::AllowEmptyClassElision>(this),
+    _size(0) {
+  }
+
+  void saveBinary(const void *, size_t size) {
+    _size += size;
+  }
+
+  size_t size() const {
+    return _size;
+  }
+};
+
+// Binary output archive writing straight into a pre-sized memory block. The
+// wire format is identical to cereal's BinaryOutputArchive.
+class PacketOutputArchive : public cereal::OutputArchive<PacketOutputArchive, cereal::AllowEmptyClassElision> {
+private:
+  uint8_t *_data;
+  size_t _length;
+  size_t _position;
+
+public:
+  PacketOutputArchive(void *data, size_t length) :
+    cereal::OutputArchive<PacketOutputArchive, cereal::AllowEmptyClassElision>(this),
+    _data((uint8_t *)data),
+    _length(length),
+    _position(0) {
+  }
+
+  void saveBinary(const void *data, size_t size) {
+    if (size > remaining()) {
+      throw cereal::Exception("Failed to write " + std::to_string(size) + " bytes to packet, " + std::to_string(remaining()) + " bytes left");
+    }
+
+    memcpy(_data + _position, data, size);
+    _position += size;
+  }
+
+  size_t remaining() const {
+    return _length - _position;
+  }
+};
+
+// upper bounds for untrusted length prefixes while decoding a packet
+typedef struct {
+  size_t maxElements;
+  size_t maxStringLength;
+} packetLimits_t;
+
+// Binary input archive reading straight from a memory block (e.g. the data of
+// an ENetPacket). The wire format is identical to cereal's BinaryInputArchive,
+// but no copy of the buffer and no stream objects are created while decoding.
+//
+// Every length prefix is checked against the limits and the bytes left in the
+// block before anything gets allocated for it, as each element or character
+// takes at least one byte on the wire.
+class PacketInputArchive : public cereal::InputArchive<PacketInputArchive, cereal::AllowEmptyClassElision> {
+private:
+  const uint8_t *_data;
+  size_t _length;
+  size_t _position;
+  packetLimits_t _limits;
+
+public:
+  PacketInputArchive(const void *data, size_t length, packetLimits_t limits) :
+    cereal::InputArchive<PacketInputArchive, cereal::AllowEmptyClassElision>(this),
+    _data((const uint8_t *)data),
+    _length(length),
+    _position(0),
+    _limits(limits) {
+  }
+
+  void loadBinary(void *const data, size_t size) {
+    if (size > remaining()) {
+      throw cereal::Exception("Failed to read " + std::to_string(size) + " bytes from packet, " + std::to_string(remaining()) + " bytes left");
+    }
+
+    memcpy(data, _data + _position, size);
+    _position += size;
+  }
+
+  // get a pointer to the next bytes of the block without copying them
+  const void *loadView(size_t size) {
+    if (size > remaining()) {
+      throw cereal::Exception("Failed to read " + std::to_string(size) + " bytes from packet, " + std::to_string(remaining()) + " bytes left");
+    }
+
+    auto view = _data + _position;
+    _position += size;
+
+    return view;
+  }
+
+  size_t remaining() const {
+    return _length - _position;
+  }
+
+  void verifyElementCount(uint64_t count) const {
+    if (count > _limits.maxElements || count > remaining()) {
+      throw cereal::Exception("Rejected list of " + std::to_string(count) + " elements, " + std::to_string(remaining()) + " bytes left");
+    }
+  }
+
+  void verifyStringLength(uint64_t length) const {
+    if (length > _limits.maxStringLength || length > remaining()) {
+      throw cereal::Exception("Rejected string of " + std::to_string(length) + " characters, " + std::to_string(remaining()) + " bytes left");
+    }
+  }
+};
+
+// load arithmetic types
+template <class T>
+inline typename std::enable_if<std::is_arithmetic<T>::value, void>::type
+CEREAL_LOAD_FUNCTION_NAME(PacketInputArchive &ar, T &t) {
+  ar.loadBinary(std::addressof(t), sizeof(t));
+}
+
+// names are not part of the binary format
+template <class T>
+inline void CEREAL_SERIALIZE_FUNCTION_NAME(PacketInputArchive &ar, cereal::NameValuePair<T> &t) {
+  ar(t.value);
+}
+
+// size tags precede lists, the container is resized right after loading them
+template <class T>
+inline void CEREAL_SERIALIZE_FUNCTION_NAME(PacketInputArchive &ar, cereal::SizeTag<T> &t) {
+  ar(t.size);
+  ar.verifyElementCount((uint64_t)t.size);
+}
+
+// strings are loaded here instead of cereal's generic implementation to check
+// their length against the string limit instead of the element limit
+inline void CEREAL_LOAD_FUNCTION_NAME(PacketInputArchive &ar, std::string &str) {
+  cereal::size_type length;
+  ar.loadBinary(&length, sizeof(length));
+  ar.verifyStringLength((uint64_t)length);
+
+  str.resize((size_t)length);
+  ar.loadBinary(&str[0], (size_t)length);
+}
+
+template <class T>
+inline void CEREAL_LOAD_FUNCTION_NAME(PacketInputArchive &ar, cereal::BinaryData<T> &bd) {
+  ar.loadBinary(bd.data, (size_t)bd.size);
+}
+
+// save arithmetic types
+template <class T>
+inline typename std::enable_if<std::is_arithmetic<T>::value, void>::type
+CEREAL_SAVE_FUNCTION_NAME(PacketSizeArchive &ar, const T &t) {
+  ar.saveBinary(std::addressof(t), sizeof(t));
+}
+
+template <class T>
+inline typename std::enable_if<std::is_arithmetic<T>::value, void>::type
+CEREAL_SAVE_FUNCTION_NAME(PacketOutputArchive &ar, const T &t) {
+  ar.saveBinary(std::addressof(t), sizeof(t));
+}
+
+template <class T>
+inline void CEREAL_SERIALIZE_FUNCTION_NAME(PacketSizeArchive &ar, cereal::NameValuePair<T> &t) {
+  ar(t.value);
+}
+
+template <class T>
+inline void CEREAL_SERIALIZE_FUNCTION_NAME(PacketOutputArchive &ar, cereal::NameValuePair<T> &t) {
+  ar(t.value);
+}
+
+template <class T>
+inline void CEREAL_SERIALIZE_FUNCTION_NAME(PacketSizeArchive &ar, cereal::SizeTag<T> &t) {
+  ar(t.size);
+}
+
+template <class T>
+inline void CEREAL_SERIALIZE_FUNCTION_NAME(PacketOutputArchive &ar, cereal::SizeTag<T> &t) {
+  ar(t.size);
+}
+
+template <class T>
+inline void CEREAL_SAVE_FUNCTION_NAME(PacketSizeArchive &ar, const cereal::BinaryData<T> &bd) {
+  ar.saveBinary(bd.data, (size_t)bd.size);
+}
+
+template <class T>
+inline void CEREAL_SAVE_FUNCTION_NAME(PacketOutputArchive &ar, const cereal::BinaryData<T> &bd) {
+  ar.saveBinary(bd.data, (size_t)bd.size);
+}
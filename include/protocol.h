@@ -27,26 +27,56 @@
 
 #pragma once
 
-#include <cereal/archives/binary.hpp>
+#include <enet/enet.h>
 #include <cereal/types/vector.hpp>
 #include <cereal/types/string.hpp>
-#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <new>
+
+#include "packetArchive.h"
 
 #define PROTOCOL_VERSION_MAJOR 1
-#define PROTOCOL_VERSION_MINOR 3
+#define PROTOCOL_VERSION_MINOR 4
 #define PROTOCOL_MIN_VERSION_MAJOR 1
 #define PROTOCOL_MIN_VERSION_MINOR 3
 
 #define ENET_PORT 23332
 #define HTTP_PORT 23333
 
-#define NETWORK_CHANNELS 6
+#define NETWORK_CHANNELS 8
 #define NETWORK_PROTOCOL_CHANNEL 0
 #define NETWORK_HANDSHAKE_CHANNEL 1
 #define NETWORK_UPDATE_CHANNEL 2
 #define NETWORK_STATUS_CHANNEL 3
 #define NETWORK_CONTROL_CHANNEL 4
 #define NETWORK_POSITION_CHANNEL 5
+#define NETWORK_POSITION_FRAME_CHANNEL 6 // since protocol 1.4
+#define NETWORK_BATCH_CHANNEL 7 // since protocol 1.4
+
+// optional protocol features, agreed on in the protocol handshake
+//
+// compression: the client decodes range coded datagrams right after connecting
+// and only compresses its own datagrams after receiving the protocol response,
+// the server has to be able to decode them once it sent that response
+#define PROTOCOL_CAPABILITY_COMPRESSION (1 << 0)
+#define PROTOCOL_CAPABILITY_POSITION_FRAMES (1 << 1)
+#define PROTOCOL_CAPABILITY_DELTA_POSITIONS (1 << 2)
+#define PROTOCOL_CAPABILITY_QUANTIZED_POSITIONS (1 << 3)
+#define PROTOCOL_CAPABILITY_BATCHING (1 << 4)
+#define PROTOCOL_CAPABILITY_UNRELIABLE_POSITIONS (1 << 5)
+
+#define PROTOCOL_CLIENT_CAPABILITIES (PROTOCOL_CAPABILITY_COMPRESSION | PROTOCOL_CAPABILITY_POSITION_FRAMES | PROTOCOL_CAPABILITY_DELTA_POSITIONS | PROTOCOL_CAPABILITY_QUANTIZED_POSITIONS | PROTOCOL_CAPABILITY_BATCHING | PROTOCOL_CAPABILITY_UNRELIABLE_POSITIONS)
+
+#define POSITION_FRAME_KEYFRAME 0
+#define POSITION_FRAME_DELTA 1
+
+#define POSITION_ENCODING_FLOAT 0
+#define POSITION_ENCODING_QUANTIZED 1
+
+#define PACKET_MAX_ELEMENTS 1024
+#define PACKET_MAX_STRING_LENGTH 256
 
 #define STATUS_CODE_OK 0
 #define STATUS_CODE_UNKNOWN_ERROR 1
@@ -61,15 +91,93 @@
 #define DISCONNECT_STATUS_OUTDATED_CLIENT 3
 #define DISCONNECT_STATUS_REJECTED 4
 
+inline bool isLittleEndianHost() {
+  const uint16_t value = 1;
+  return *(const uint8_t *)&value == 1;
+}
+
+inline void swapByteOrder(void *data, size_t count, size_t width) {
+  auto bytes = (uint8_t *)data;
+
+  for (size_t i = 0; i < count; i++) {
+    std::reverse(bytes + i * width, bytes + (i + 1) * width);
+  }
+}
+
+// write an array of fixed width values in little-endian byte order
+template <class Archive, class T>
+inline void saveLittleEndian(Archive &ar, const T *data, size_t count) {
+  if (isLittleEndianHost()) {
+    ar(cereal::binary_data((const void *)data, count * sizeof(T)));
+    return;
+  }
+
+  std::vector<T> swapped(data, data + count);
+  swapByteOrder(swapped.data(), count, sizeof(T));
+
+  ar(cereal::binary_data((const void *)swapped.data(), count * sizeof(T)));
+}
+
+// read an array of fixed width values in little-endian byte order
+template <class Archive, class T>
+inline void loadLittleEndian(Archive &ar, T *data, size_t count) {
+  ar(cereal::binary_data((void *)data, count * sizeof(T)));
+
+  if (isLittleEndianHost() == false) {
+    swapByteOrder(data, count, sizeof(T));
+  }
+}
+
+// convert fixed-point values relative to an origin back to floats, kept as
+// plain loop over contiguous arrays to be vectorized by the compiler
+template <class T>
+inline void dequantizeValues(const T *values, size_t count, float origin, float scale, float *output) {
+  for (size_t i = 0; i < count; i++) {
+    output[i] = origin + (float)values[i] * scale;
+  }
+}
+
+template <class T>
+inline void quantizeValues(const float *values, size_t count, float origin, float scale, T *output) {
+  const float minimum = (float)std::numeric_limits<T>::min();
+  const float maximum = (float)std::numeric_limits<T>::max();
+
+  for (size_t i = 0; i < count; i++) {
+    float value = std::round((values[i] - origin) / scale);
+    output[i] = (T)std::max(minimum, std::min(maximum, value));
+  }
+}
+
+// fields appended to existing packets are only read if the sender included them
+template <class Archive>
+inline bool hasOptionalFields(Archive &) {
+  return true;
+}
+
+inline bool hasOptionalFields(PacketInputArchive &ar) {
+  return ar.remaining() > 0;
+}
+
+// check list sizes read by custom loaders before allocating memory for them
+template <class Archive>
+inline void verifyElementCount(Archive &, uint64_t) {
+}
+
+inline void verifyElementCount(PacketInputArchive &ar, uint64_t count) {
+  ar.verifyElementCount(count);
+}
+
 typedef struct {
   int versionMajor;
   int versionMinor;
   int minimumVersionMajor;
   int minimumVersionMinor;
 
+  uint32_t capabilities;
+
   template <class Archive>
   void serialize(Archive &ar) {
-    ar(CEREAL_NVP(versionMajor), CEREAL_NVP(versionMinor), CEREAL_NVP(minimumVersionMajor), CEREAL_NVP(minimumVersionMinor));
+    ar(CEREAL_NVP(versionMajor), CEREAL_NVP(versionMinor), CEREAL_NVP(minimumVersionMajor), CEREAL_NVP(minimumVersionMinor), CEREAL_NVP(capabilities));
   }
 } protocolPacket_t;
 
@@ -79,9 +187,23 @@ typedef struct {
   int versionMajor;
   int versionMinor;
 
+  uint32_t capabilities;
+
   template <class Archive>
-  void serialize(Archive &ar) {
+  void save(Archive &ar) const {
+    ar(CEREAL_NVP(statusCode), CEREAL_NVP(versionMajor), CEREAL_NVP(versionMinor), CEREAL_NVP(capabilities));
+  }
+
+  template <class Archive>
+  void load(Archive &ar) {
     ar(CEREAL_NVP(statusCode), CEREAL_NVP(versionMajor), CEREAL_NVP(versionMinor));
+
+    // servers before protocol 1.4 do not send capabilities
+    capabilities = 0;
+
+    if (hasOptionalFields(ar)) {
+      ar(CEREAL_NVP(capabilities));
+    }
   }
 } protocolResponsePacket_t;
 
@@ -112,6 +234,169 @@ typedef struct {
   }
 } positionPacket_t;
 
+// Position batch with a fixed little-endian struct-of-arrays layout: frame
+// type, encoding, keyframe sequence, listener position and rotation, the
+// number of entries as 16 bit value, followed by packed arrays of teamspeak
+// ids, x, y, z and voice ranges. Delta frames only carry the entries that
+// changed since the referenced keyframe and append the ids that are no longer
+// part of it.
+//
+// Quantized frames add a scale factor and store coordinates as signed 16 bit
+// offsets to the listener position and voice ranges as unsigned 16 bit values,
+// each multiplied by the scale.
+typedef struct {
+  uint8_t frameType;
+  uint8_t encoding;
+  uint16_t keyframe;
+  float scale;
+
+  float x;
+  float y;
+  float z;
+  float rotation;
+
+  std::vector<uint16_t> teamspeakIds;
+  std::vector<float> positionsX;
+  std::vector<float> positionsY;
+  std::vector<float> positionsZ;
+  std::vector<float> voiceRanges;
+
+  std::vector<uint16_t> removedIds;
+
+  template <class Archive>
+  void save(Archive &ar) const {
+    float listener[4] = { x, y, z, rotation };
+    uint16_t count = (uint16_t)teamspeakIds.size();
+    uint16_t removedCount = (uint16_t)removedIds.size();
+
+    if (teamspeakIds.size() > UINT16_MAX || positionsX.size() != count || positionsY.size() != count || positionsZ.size() != count || voiceRanges.size() != count) {
+      throw cereal::Exception("Invalid position frame array sizes");
+    }
+
+    if (removedIds.size() > UINT16_MAX) {
+      throw cereal::Exception("Invalid position frame removed ids size");
+    }
+
+    saveLittleEndian(ar, &frameType, 1);
+    saveLittleEndian(ar, &encoding, 1);
+    saveLittleEndian(ar, &keyframe, 1);
+    saveLittleEndian(ar, listener, 4);
+    saveLittleEndian(ar, &count, 1);
+    saveLittleEndian(ar, teamspeakIds.data(), count);
+
+    if (encoding == POSITION_ENCODING_QUANTIZED) {
+      if ((scale > 0.0f) == false) {
+        throw cereal::Exception("Invalid position frame scale");
+      }
+
+      std::vector<int16_t> offsets(count * 3);
+      std::vector<uint16_t> ranges(count);
+
+      quantizeValues(positionsX.data(), count, x, scale, offsets.data());
+      quantizeValues(positionsY.data(), count, y, scale, offsets.data() + count);
+      quantizeValues(positionsZ.data(), count, z, scale, offsets.data() + count * 2);
+      quantizeValues(voiceRanges.data(), count, 0.0f, scale, ranges.data());
+
+      saveLittleEndian(ar, &scale, 1);
+      saveLittleEndian(ar, offsets.data(), offsets.size());
+      saveLittleEndian(ar, ranges.data(), count);
+    } else {
+      saveLittleEndian(ar, positionsX.data(), count);
+      saveLittleEndian(ar, positionsY.data(), count);
+      saveLittleEndian(ar, positionsZ.data(), count);
+      saveLittleEndian(ar, voiceRanges.data(), count);
+    }
+
+    if (frameType == POSITION_FRAME_DELTA) {
+      saveLittleEndian(ar, &removedCount, 1);
+      saveLittleEndian(ar, removedIds.data(), removedCount);
+    }
+  }
+
+  template <class Archive>
+  void load(Archive &ar) {
+    float listener[4];
+    uint16_t count;
+
+    loadLittleEndian(ar, &frameType, 1);
+    loadLittleEndian(ar, &encoding, 1);
+    loadLittleEndian(ar, &keyframe, 1);
+    loadLittleEndian(ar, listener, 4);
+    loadLittleEndian(ar, &count, 1);
+
+    if (frameType != POSITION_FRAME_KEYFRAME && frameType != POSITION_FRAME_DELTA) {
+      throw cereal::Exception("Unknown position frame type " + std::to_string(frameType));
+    }
+
+    if (encoding != POSITION_ENCODING_FLOAT && encoding != POSITION_ENCODING_QUANTIZED) {
+      throw cereal::Exception("Unknown position frame encoding " + std::to_string(encoding));
+    }
+
+    x = listener[0];
+    y = listener[1];
+    z = listener[2];
+    rotation = listener[3];
+
+    verifyElementCount(ar, count);
+
+    teamspeakIds.resize(count);
+    positionsX.resize(count);
+    positionsY.resize(count);
+    positionsZ.resize(count);
+    voiceRanges.resize(count);
+
+    loadLittleEndian(ar, teamspeakIds.data(), count);
+
+    if (encoding == POSITION_ENCODING_QUANTIZED) {
+      loadLittleEndian(ar, &scale, 1);
+
+      if ((scale > 0.0f) == false) {
+        throw cereal::Exception("Invalid position frame scale");
+      }
+
+      std::vector<int16_t> offsets(count * 3);
+      std::vector<uint16_t> ranges(count);
+
+      loadLittleEndian(ar, offsets.data(), offsets.size());
+      loadLittleEndian(ar, ranges.data(), count);
+
+      dequantizeValues(offsets.data(), count, x, scale, positionsX.data());
+      dequantizeValues(offsets.data() + count, count, y, scale, positionsY.data());
+      dequantizeValues(offsets.data() + count * 2, count, z, scale, positionsZ.data());
+      dequantizeValues(ranges.data(), count, 0.0f, scale, voiceRanges.data());
+    } else {
+      scale = 0.0f;
+
+      loadLittleEndian(ar, positionsX.data(), count);
+      loadLittleEndian(ar, positionsY.data(), count);
+      loadLittleEndian(ar, positionsZ.data(), count);
+      loadLittleEndian(ar, voiceRanges.data(), count);
+    }
+
+    removedIds.clear();
+
+    if (frameType == POSITION_FRAME_DELTA) {
+      uint16_t removedCount;
+      loadLittleEndian(ar, &removedCount, 1);
+      verifyElementCount(ar, removedCount);
+
+      removedIds.resize(removedCount);
+      loadLittleEndian(ar, removedIds.data(), removedCount);
+    }
+  }
+} positionFramePacket_t;
+
+// Acknowledges a received keyframe, the server bases following delta frames
+// on the last acknowledged keyframe
+typedef struct {
+  uint16_t keyframe;
+
+  template <class Archive>
+  void serialize(Archive &ar) {
+    ar(CEREAL_NVP(keyframe));
+  }
+} positionFrameAckPacket_t;
+
 typedef struct {
   uint16_t teamspeakId;
   bool muted;
@@ -133,9 +418,26 @@ typedef struct {
   uint64_t channelId;
   std::string channelPassword;
 
+  // issued to resume this session after a lost connection
+  std::string resumptionToken;
+  bool resumed;
+
   template <class Archive>
-  void serialize(Archive &ar) {
+  void save(Archive &ar) const {
+    ar(CEREAL_NVP(statusCode), CEREAL_NVP(reason), CEREAL_NVP(teamspeakServerUniqueIdentifier), CEREAL_NVP(channelId), CEREAL_NVP(channelPassword), CEREAL_NVP(resumptionToken), CEREAL_NVP(resumed));
+  }
+
+  template <class Archive>
+  void load(Archive &ar) {
     ar(CEREAL_NVP(statusCode), CEREAL_NVP(reason), CEREAL_NVP(teamspeakServerUniqueIdentifier), CEREAL_NVP(channelId), CEREAL_NVP(channelPassword));
+
+    // servers without session resumption do not send a token
+    resumptionToken = "";
+    resumed = false;
+
+    if (hasOptionalFields(ar)) {
+      ar(CEREAL_NVP(resumptionToken), CEREAL_NVP(resumed));
+    }
   }
 } handshakeResponsePacket_t;
 
@@ -146,9 +448,23 @@ typedef struct {
 
   std::string teamspeakClientUniqueIdentity;
 
+  // token of the session to resume, empty when joining
+  std::string resumptionToken;
+
   template <class Archive>
-  void serialize(Archive &ar) {
+  void save(Archive &ar) const {
+    ar(CEREAL_NVP(gameId), CEREAL_NVP(teamspeakId), CEREAL_NVP(statusCode), CEREAL_NVP(teamspeakClientUniqueIdentity), CEREAL_NVP(resumptionToken));
+  }
+
+  template <class Archive>
+  void load(Archive &ar) {
     ar(CEREAL_NVP(gameId), CEREAL_NVP(teamspeakId), CEREAL_NVP(statusCode), CEREAL_NVP(teamspeakClientUniqueIdentity));
+
+    resumptionToken = "";
+
+    if (hasOptionalFields(ar)) {
+      ar(CEREAL_NVP(resumptionToken));
+    }
   }
 } handshakePacket_t;
 
@@ -162,6 +478,54 @@ typedef struct {
   }
 } updatePacket_t;
 
+typedef struct {
+  uint8_t channelId;
+  uint32_t length;
+  const void *data;
+} batchEntry_t;
+
+// Several messages of other channels combined into one network packet: the
+// number of messages as 16 bit value, followed by channel id, 32 bit payload
+// length and payload of each message, all in little-endian byte order.
+// Loaded payloads point into the decoded buffer and are only valid as long as
+// the buffer is. Batches are always reliable, unreliable messages are sent on
+// their own channel. Once batching is agreed every reliable message is sent
+// in a batch, even a single one, to keep them in order.
+typedef struct {
+  std::vector<batchEntry_t> entries;
+
+  template <class Archive>
+  void save(Archive &ar) const {
+    uint16_t count = (uint16_t)entries.size();
+
+    if (entries.size() > UINT16_MAX) {
+      throw cereal::Exception("Invalid batch size");
+    }
+
+    saveLittleEndian(ar, &count, 1);
+
+    for (auto it = entries.begin(); it != entries.end(); it++) {
+      saveLittleEndian(ar, &(*it).channelId, 1);
+      saveLittleEndian(ar, &(*it).length, 1);
+      ar(cereal::binary_data((const void *)(*it).data, (*it).length));
+    }
+  }
+
+  void load(PacketInputArchive &ar) {
+    uint16_t count;
+    loadLittleEndian(ar, &count, 1);
+    verifyElementCount(ar, count);
+
+    entries.resize(count);
+
+    for (auto it = entries.begin(); it != entries.end(); it++) {
+      loadLittleEndian(ar, &(*it).channelId, 1);
+      loadLittleEndian(ar, &(*it).length, 1);
+      (*it).data = ar.loadView((*it).length);
+    }
+  }
+} batchPacket_t;
+
 typedef struct {
   bool talking;
   bool microphoneMuted;
@@ -201,36 +565,83 @@ inline bool verifyProtocolVersion(int major, int minor, int minMajor, int minMin
 }
 
 template <class T>
-inline std::string serializePacket(T &packet, bool *result) {
-  std::ostringstream os;
+inline ENetPacket *serializePacket(T &packet, bool *result, enet_uint32 flags = ENET_PACKET_FLAG_RELIABLE) {
+  ENetPacket *outputPacket = nullptr;
 
   try {
-    cereal::BinaryOutputArchive archive(os);
+    // measure payload to allocate the network packet only once
+    PacketSizeArchive sizeArchive;
+    sizeArchive(packet);
+
+    outputPacket = enet_packet_create(NULL, sizeArchive.size(), flags);
+    if (outputPacket == NULL) {
+      throw std::bad_alloc();
+    }
+
+    PacketOutputArchive archive(outputPacket->data, outputPacket->dataLength);
     archive(packet);
   } catch (std::exception &e) {
+    if (outputPacket != nullptr) {
+      enet_packet_destroy(outputPacket);
+    }
+
     if (result != nullptr) {
       *result = false;
     }
 
-    return "";
+    return nullptr;
   }
 
   if (result != nullptr) {
     *result = true;
   }
 
-  auto data = os.str();
+  return outputPacket;
 }
 
+// decoding limits per packet type, packets exceeding them are rejected
 template <class T>
-inline T &deserializePacket(ENetPacket *packet, bool *result) {
-  std::string data((char *)packet->data, packet->dataLength);
-  std::istringstream is(data);
+inline packetLimits_t packetLimits() {
+  packetLimits_t limits;
+  limits.maxElements = PACKET_MAX_ELEMENTS;
+  limits.maxStringLength = PACKET_MAX_STRING_LENGTH;
+
+  return limits;
+}
+
+template <>
+inline packetLimits_t packetLimits<positionFramePacket_t>() {
+  packetLimits_t limits;
+  limits.maxElements = UINT16_MAX;
+  limits.maxStringLength = 0;
+
+  return limits;
+}
+
+template <>
+inline packetLimits_t packetLimits<batchPacket_t>() {
+  packetLimits_t limits;
+  limits.maxElements = PACKET_MAX_ELEMENTS;
+  limits.maxStringLength = 0;
 
+  return limits;
+}
+
+template <>
+inline packetLimits_t packetLimits<protocolResponsePacket_t>() {
+  packetLimits_t limits;
+  limits.maxElements = 0;
+  limits.maxStringLength = 0;
+
+  return limits;
+}
+
+template <class T>
+inline T deserializePacket(const void *data, size_t length, bool *result) {
   T outputPacket;
 
   try {
-    cereal::BinaryInputArchive archive(is);
+    PacketInputArchive archive(data, length, packetLimits<T>());
     archive(outputPacket);
   } catch (std::exception &e) {
     if (result != nullptr) {
@@ -246,3 +657,8 @@ inline T &deserializePacket(ENetPacket *packet, bool *result) {
 
   return outputPacket;
 }
+
+template <class T>
+inline T deserializePacket(ENetPacket *packet, bool *result) {
+  return deserializePacket<T>(packet->data, packet->dataLength, result);
+}
@@ -29,21 +29,47 @@
 
 #include <string>
 #include <set>
+#include <vector>
+#include <stdint.h>
 #include <teamspeak/public_definitions.h>
 
+// default distance a client has to move before teamspeak gets its new
+// position (in mm)
+#define TEAMSPEAK_POSITION_EPSILON 10
+
+// longest time to wait for teamspeak to subscribe to a channel (in ms)
+#define TEAMSPEAK_SUBSCRIBE_TIMEOUT 2000
+
+typedef struct {
+  anyID clientId;
+  float x;
+  float y;
+  float z;
+} ts3ClientPosition_t;
+
 // wrapped functions
 void ts3_log(std::string message, enum LogLevel severity);
+std::string ts3_getConfigPath();
 
 bool ts3_verifyServer(std::string uniqueIdentifier);
 bool ts3_moveToChannel(uint64 channelId, std::string password);
 bool ts3_muteClient(anyID clientId, bool mute);
 bool ts3_muteClients(std::set<anyID> &clients, bool mute);
 bool ts3_unmuteAllClients();
+void ts3_forgetClient(anyID clientId);
+void ts3_forgetClients(uint64 serverConnectionHandlerId);
+bool ts3_subscribeChannel(uint64 channelId, uint32_t timeout);
+void ts3_channelSubscriptionChanged();
 std::set<anyID> ts3_clientsInChannel(uint64 channelId);
+void ts3_channelMemberMoved(uint64 serverConnectionHandlerId, anyID clientId, uint64 oldChannelId, uint64 newChannelId);
+void ts3_forgetChannelMembers(uint64 serverConnectionHandlerId, uint64 channelId);
 bool ts3_setNickname(std::string nickname);
 bool ts3_resetNickname();
 std::string ts3_getClientIdentity();
 bool ts3_setClientPosition(anyID clientID, float x, float y, float z);
+bool ts3_setClientPositions(const std::vector<ts3ClientPosition_t> &positions);
+void ts3_setPositionEpsilon(float epsilon);
+void ts3_positionCounters(uint64_t *applied, uint64_t *skipped);
 bool ts3_resetListenerPosition();
 bool ts3_set3DSettings(float distanceFactor, float rolloffScale);
 void ts3_resetClients3DPositions();
@@ -51,6 +77,8 @@ void ts3_resetClients3DPositions();
 uint64 ts3_serverConnectionHandle();
 anyID ts3_clientId(uint64 serverConnectionHandlerId);
 uint64 ts3_channelId(uint64 serverConnectionHandlerId);
+void ts3_ownChannelChanged(uint64 serverConnectionHandlerId, uint64 channelId);
+void ts3_invalidateOwnClient(uint64 serverConnectionHandlerId);
 bool ts3_isInputMuted(uint64 serverConnectionHandlerId);
 bool ts3_isOutputMuted(uint64 serverConnectionHandlerId);
 bool ts3_setOutputMuted(uint64 serverConnectionHandlerId, bool muted);
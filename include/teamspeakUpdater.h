@@ -0,0 +1,95 @@
+/*
+ * File: include/teamspeakUpdater.h
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <set>
+#include <teamspeak/public_definitions.h>
+
+#include "motionModel.h"
+#include "teamspeak.h"
+
+// shortest time between two runs applying updates to teamspeak, positions
+// of moving clients are rendered at this cadence as well (in ms)
+#define TEAMSPEAK_UPDATE_INTERVAL 20
+
+typedef struct {
+  clientPosition_t position;
+  motionTime_t time;
+} positionSample_t;
+
+// Second stage of handling voice server updates. The network thread only
+// records the latest mute state and position per client, a separate thread
+// applies them to teamspeak at a bounded rate. Updates superseded before
+// being applied are never sent to teamspeak, and slow teamspeak calls do not
+// hold up receiving newer packets. Positions are smoothed by a motion model
+// per client between the samples sent by the voice server.
+class TeamspeakUpdater {
+private:
+  std::thread *_thread;
+  std::atomic<bool> _running;
+  uint32_t _interval;
+
+  std::mutex _pendingMutex;
+  std::condition_variable _pendingCondition;
+  std::unordered_map<anyID, bool> _pendingMutes;
+  std::unordered_map<anyID, positionSample_t> _pendingPositions;
+  std::string _pendingNickname;
+  bool _hasPendingNickname;
+  std::set<anyID> _forgottenClients;
+  uint64_t _forgetGeneration;
+
+  std::mutex _applyMutex;
+  std::unordered_map<anyID, MotionModel> _motions;
+
+public:
+  TeamspeakUpdater();
+  virtual ~TeamspeakUpdater();
+
+  void start(uint32_t interval = TEAMSPEAK_UPDATE_INTERVAL);
+  void stop();
+
+  void setMuted(anyID clientId, bool muted);
+  void setPosition(anyID clientId, float x, float y, float z);
+  void setPositions(const std::vector<ts3ClientPosition_t> &positions);
+  void setNickname(std::string nickname);
+
+  void forget(anyID clientId);
+  void clear();
+
+private:
+  void update();
+  bool apply();
+  bool hasPendingUpdates() const;
+  std::set<anyID> forgottenSince(uint64_t generation);
+};
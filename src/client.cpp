@@ -29,134 +29,184 @@
 
 #include "teamspeak.h"
 
-Client::Client() {
+#include <string.h>
+
+BIND_CHANNEL(Client, NETWORK_PROTOCOL_CHANNEL, protocolResponsePacket_t, handleProtocolResponse);
+BIND_CHANNEL(Client, NETWORK_HANDSHAKE_CHANNEL, handshakeResponsePacket_t, handleHandshakeResponse);
+BIND_CHANNEL(Client, NETWORK_UPDATE_CHANNEL, updatePacket_t, handleUpdateMessage);
+IGNORE_CHANNEL(Client, NETWORK_STATUS_CHANNEL);
+BIND_CHANNEL(Client, NETWORK_CONTROL_CHANNEL, controlPacket_t, handleControlMessage);
+BIND_CHANNEL(Client, NETWORK_POSITION_CHANNEL, positionPacket_t, handlePositionMessage);
+BIND_CHANNEL(Client, NETWORK_POSITION_FRAME_CHANNEL, positionFramePacket_t, handlePositionFrameMessage);
+BIND_CHANNEL(Client, NETWORK_BATCH_CHANNEL, batchPacket_t, handleBatchMessage);
+
+Client::Client(clientConfig_t config) {
   _client = nullptr;
   _peer = nullptr;
+  _config = config;
   _thread = nullptr;
   _running = false;
+  _state = CLIENT_STATE_DISCONNECTED;
+  _targetPort = 0;
+  _targetGameId = 0;
+  _connectRequested = false;
+  _disconnectRequested = false;
+  _disconnecting = false;
+  _disconnectTimeout = config.disconnectTimeout;
+  _joinStep = CLIENT_JOIN_NONE;
+  _joinChannelId = 0;
+  _joinLastChannelId = 0;
+  _joinTempMute = false;
+  _reconnecting = false;
+  _reconnectAttempts = 0;
+  _lastPeerActivity = 0;
   _gameId = 0;
   _teamspeakId = 0;
+  _port = 0;
   _talking = false;
   _microphoneMuted = false;
   _speakersMuted = false;
   _lastChannelId = 0;
-}
-
-Client::~Client() {
-  close();
-}
-
-bool Client::connect(std::string host, uint16_t port, uint16_t uniqueIdentifier) {
-  if (host == _host && _port == port && _gameId == uniqueIdentifier) {
-    return true;
+  _capabilities = 0;
+  _rangeCoder = nullptr;
+  _compressOutgoing = false;
+  _rejectedPackets = 0;
+  _droppedCommands = false;
+  _statusInterval = config.statusInterval;
+  _hasPendingStatus = false;
+  _hasSentStatus = false;
+
+  ts3_setPositionEpsilon(config.positionEpsilon / 1000.0f);
+
+  memset(&_stats, 0, sizeof(_stats));
+  _stats.state = CLIENT_STATE_DISCONNECTED;
+
+  if (_wakeup.open() == false) {
+    ts3_log("Unable to open network wakeup socket, falling back to polling", LogLevel_WARNING);
   }
 
-  if (isOpen()) {
-    disconnect(DISCONNECT_STATUS_RECONNECT);
-  }
+  // network thread lives as long as the client
+  _updater.start();
 
-  ts3_log("Creating network client", LogLevel_DEBUG);
+  _running = true;
+  _thread = new std::thread(&Client::update, this);
+}
 
-  _client = enet_host_create(NULL, 1, NETWORK_CHANNELS, 0, 0);
-  if (_client == NULL) {
-    _client = nullptr;
-    return false;
+Client::~Client() {
+  // let the network thread finish a graceful disconnect, bounded by its deadline
+  if (isOpen() && disconnect(DISCONNECT_STATUS_OK)) {
+    waitForState(CLIENT_STATE_DISCONNECTED, _disconnectTimeout + NETWORK_SERVICE_TIMEOUT);
   }
 
-  // connect to host
-  ENetAddress address;
-  enet_address_set_host(&address, host.c_str());
-  address.port = port;
-
-  ts3_log("Connecting to voice server", LogLevel_DEBUG);
+  abortThread();
+  _updater.stop();
 
-  _peer = enet_host_connect(_client, &address, NETWORK_CHANNELS, 0);
-  if (_peer == NULL) {
-    close();
-    return false;
+  if (_rangeCoder != nullptr) {
+    enet_range_coder_destroy(_rangeCoder);
+    _rangeCoder = nullptr;
   }
+}
 
-  // check if connecting is successful
-  ENetEvent event;
-  if (enet_host_service(_client, &event, 5000) <= 0 || event.type != ENET_EVENT_TYPE_CONNECT) {
-    close();
-    return false;
-  }
+bool Client::connect(std::string host, uint16_t port, uint16_t uniqueIdentifier) {
+  {
+    std::lock_guard<std::mutex> lock(_stateMutex);
 
-  abortThread();
+    // already connecting or connected to this server, a pending disconnect ends that connection
+    bool disconnecting = _disconnectRequested || _disconnecting;
+    if (_state != CLIENT_STATE_DISCONNECTED && disconnecting == false && host == _targetHost && port == _targetPort && uniqueIdentifier == _targetGameId) {
+      return true;
+    }
 
-  _gameId = uniqueIdentifier;
-  _host = host;
-  _port = port;
-  _teamspeakId = 0;
-  _running = true;
+    auto previousHost = _targetHost;
+    auto previousPort = _targetPort;
+    auto previousGameId = _targetGameId;
 
-  // start update thread
-  _thread = new std::thread(&Client::update, this);
-  ts3_log("Connection established", LogLevel_DEBUG);
+    _targetHost = host;
+    _targetPort = port;
+    _targetGameId = uniqueIdentifier;
 
-  sendProtocolMessage();
-  return true;
-}
+    // the network thread reads the target only after taking the lock
+    if (postCommand(CLIENT_COMMAND_CONNECT) == false) {
+      _targetHost = previousHost;
+      _targetPort = previousPort;
+      _targetGameId = previousGameId;
+      return false;
+    }
 
-void Client::disconnect(uint32_t status) {
-  if (_peer == nullptr) {
-    return;
+    // waiting callers see the new attempt right away
+    _connectRequested = true;
+    _disconnectRequested = false;
+    _state = CLIENT_STATE_RESOLVING;
   }
 
-  ts3_log("Disconnecting", LogLevel_DEBUG);
+  _stateCondition.notify_all();
 
-  enet_peer_disconnect(_peer, status);
-
-  // stop main update thread
-  abortThread();
+  return true;
+}
 
-  ENetEvent event;
-  while (_client != nullptr && enet_host_service(_client, &event, 3000) > 0) {
-    if (event.type == ENET_EVENT_TYPE_DISCONNECT) {
-      break;
-    }
+bool Client::disconnect(uint32_t status) {
+  std::lock_guard<std::mutex> lock(_stateMutex);
 
-    // discard any other event
-    if (event.packet != 0) {
-      enet_packet_destroy(event.packet);
-    }
+  if (postCommand(CLIENT_COMMAND_DISCONNECT, status) == false) {
+    return false;
   }
 
-  ts3_log("Disconnected", LogLevel_INFO);
+  _disconnectRequested = true;
+  return true;
+}
 
-  _host = "";
-  _port = 0;
-  _gameId = 0;
-  _teamspeakId = 0;
+void Client::ownClientMoved(uint64_t channelId) {
+  postCommand(CLIENT_COMMAND_OWN_CLIENT_MOVED, channelId);
+}
 
-  close();
+void Client::forgetClient(anyID clientId) {
+  _updater.forget(clientId);
 }
 
 bool Client::isOpen() const {
-  return _client != nullptr && _peer != nullptr && _running;
+  return _state != CLIENT_STATE_DISCONNECTED;
 }
 
 bool Client::isIngame() const {
-  return isOpen() && _gameId != 0 && _teamspeakId != 0;
+  // a session being resumed is still in the in-game channel
+  return (_state == CLIENT_STATE_INGAME || _reconnecting) && _disconnecting == false;
+}
+
+clientState_t Client::state() const {
+  return _state;
+}
+
+bool Client::waitForState(clientState_t state, uint32_t timeout) {
+  std::unique_lock<std::mutex> lock(_stateMutex);
+
+  // states are ordered, a failed attempt falls back to disconnected
+  auto reached = [this, state]() {
+    return state == CLIENT_STATE_DISCONNECTED ? _state == CLIENT_STATE_DISCONNECTED : _state >= state;
+  };
+
+  _stateCondition.wait_for(lock, std::chrono::milliseconds(timeout), [this, &reached]() {
+    return reached() || _state == CLIENT_STATE_DISCONNECTED;
+  });
+
+  return reached();
 }
 
 void Client::setTalking(bool talking) {
   _talking = talking;
 
-  sendStatus();
+  postStatus();
 }
 
 void Client::setMicrophoneMuted(bool muted) {
   _microphoneMuted = muted;
 
-  sendStatus();
+  postStatus();
 }
 
 void Client::setSpeakersMuted(bool muted) {
   _speakersMuted = muted;
 
-  sendStatus();
+  postStatus();
 }
 
 bool Client::isTalking() const {
@@ -171,11 +221,50 @@ bool Client::hasSpeakersMuted() const {
   return _speakersMuted;
 }
 
+void Client::setDisconnectTimeout(uint32_t milliseconds) {
+  _disconnectTimeout = milliseconds;
+}
+
+uint32_t Client::disconnectTimeout() const {
+  return _disconnectTimeout;
+}
+
+void Client::setStatusInterval(uint32_t milliseconds) {
+  _statusInterval = milliseconds;
+}
+
+uint32_t Client::statusInterval() const {
+  return _statusInterval;
+}
+
+bool Client::hasCapability(uint32_t capability) const {
+  return (_capabilities & capability) == capability;
+}
+
+uint64_t Client::rejectedPackets() const {
+  return _rejectedPackets;
+}
+
+clientConfig_t Client::config() const {
+  return _config;
+}
+
+clientStats_t Client::stats() {
+  std::lock_guard<std::mutex> lock(_statsMutex);
+  return _stats;
+}
+
 void Client::close() {
   ts3_log("Closing", LogLevel_DEBUG);
 
-  abortThread();
-  
+  destroyHost();
+  resetSession();
+  resetTeamspeak();
+
+  setState(CLIENT_STATE_DISCONNECTED);
+}
+
+void Client::destroyHost() {
   if (_peer != nullptr) {
     enet_peer_reset(_peer);
     _peer = nullptr;
@@ -186,15 +275,40 @@ void Client::close() {
     _client = nullptr;
   }
 
-  _running = false;
+  _disconnecting = false;
+  _joinStep = CLIENT_JOIN_NONE;
+
+  _capabilities = 0;
+  _compressOutgoing = false;
+  discardPendingPackets();
+  _hasPendingStatus = false;
+  _hasSentStatus = false;
+  _positionKeyframes.clear();
+  _positionTable.clear();
+}
+
+void Client::resetSession() {
   _host = "";
   _port = 0;
   _gameId = 0;
   _teamspeakId = 0;
+  _resumptionToken = "";
+  _reconnecting = false;
+  _reconnectAttempts = 0;
+}
 
+void Client::resetTeamspeak() {
   // move back to old teamspeak channel
   ts3_log("Resetting teamspeak", LogLevel_DEBUG);
 
+  // updates of the closed session must not be applied after the reset
+  _updater.clear();
+
+  if (_joinTempMute) {
+    ts3_setOutputMuted(ts3_serverConnectionHandle(), false);
+    _joinTempMute = false;
+  }
+
   if (_lastChannelId == 0) {
     return;
   }
@@ -228,44 +342,307 @@ void Client::close() {
   ts3_log("Closed", LogLevel_DEBUG);
 }
 
+void Client::setState(clientState_t state) {
+  {
+    std::lock_guard<std::mutex> lock(_stateMutex);
+
+    // closing the previous connection does not hide a queued connect from waiting callers
+    if (state == CLIENT_STATE_DISCONNECTED && _connectRequested) {
+      return;
+    }
+
+    _state = state;
+  }
+
+  _stateCondition.notify_all();
+}
+
+void Client::startConnection() {
+  // replace any previous connection
+  if (_peer != nullptr) {
+    enet_peer_disconnect_now(_peer, DISCONNECT_STATUS_RECONNECT);
+  }
+
+  destroyHost();
+  resetSession();
+  resetTeamspeak();
+
+  {
+    std::lock_guard<std::mutex> lock(_stateMutex);
+    _host = _targetHost;
+    _port = _targetPort;
+    _gameId = _targetGameId;
+    _connectRequested = false;
+  }
+
+  if (openConnection() == false) {
+    close();
+  }
+}
+
+bool Client::openConnection() {
+  setState(CLIENT_STATE_RESOLVING);
+  ts3_log("Resolving voice server " + _host, LogLevel_DEBUG);
+
+  ENetAddress address;
+  if (enet_address_set_host(&address, _host.c_str()) != 0) {
+    ts3_log("Unable to resolve voice server " + _host, LogLevel_WARNING);
+    return false;
+  }
+
+  address.port = _port;
+
+  ts3_log("Creating network client", LogLevel_DEBUG);
+
+  _client = enet_host_create(NULL, 1, NETWORK_CHANNELS, _config.incomingBandwidth, _config.outgoingBandwidth);
+  if (_client == NULL) {
+    _client = nullptr;
+    return false;
+  }
+
+  // the mtu of the host is used for the connecting peer
+  _client->mtu = std::max((uint32_t)ENET_PROTOCOL_MINIMUM_MTU, std::min(_config.mtu, (uint32_t)ENET_PROTOCOL_MAXIMUM_MTU));
+
+  if (enableCompression() == false) {
+    ts3_log("Unable to enable packet compression", LogLevel_WARNING);
+  }
+
+  ts3_log("Connecting to voice server", LogLevel_DEBUG);
+
+  _peer = enet_host_connect(_client, &address, NETWORK_CHANNELS, 0);
+  if (_peer == NULL) {
+    _peer = nullptr;
+    destroyHost();
+    return false;
+  }
+
+  // detect lost connections early enough to resume the session
+  enet_peer_timeout(_peer, _config.timeoutLimit, _config.timeoutMinimum, _config.timeoutMaximum);
+  enet_peer_ping_interval(_peer, _config.pingInterval);
+
+  _connectTime = std::chrono::steady_clock::now();
+  _lastPeerActivity = enet_time_get();
+
+  setState(CLIENT_STATE_CONNECTING);
+  return true;
+}
+
+void Client::connectionLost() {
+  // only sessions which have been in-game can be resumed
+  if (_resumptionToken.empty()) {
+    close();
+    return;
+  }
+
+  destroyHost();
+
+  if (_reconnectAttempts >= CLIENT_RECONNECT_ATTEMPTS) {
+    ts3_log("Unable to resume session after " + std::to_string(_reconnectAttempts) + " attempts", LogLevel_WARNING);
+    close();
+    return;
+  }
+
+  // exponential backoff between attempts
+  uint32_t delay = std::min((uint32_t)CLIENT_RECONNECT_DELAY << _reconnectAttempts, (uint32_t)CLIENT_RECONNECT_MAX_DELAY);
+
+  _reconnecting = true;
+  _reconnectAttempts++;
+  _reconnectTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(delay);
+
+  ts3_log("Connection lost, reconnecting in " + std::to_string(delay) + " ms", LogLevel_INFO);
+  setState(CLIENT_STATE_CONNECTING);
+}
+
+void Client::startDisconnect(uint32_t status) {
+  // peers not connected yet can not confirm the disconnect
+  if (_peer == nullptr || _state < CLIENT_STATE_PROTOCOL) {
+    if (_peer != nullptr) {
+      enet_peer_disconnect_now(_peer, status);
+    }
+
+    close();
+    return;
+  }
+
+  if (_disconnecting) {
+    return;
+  }
+
+  ts3_log("Disconnecting", LogLevel_DEBUG);
+
+  // queued messages are still sent before the disconnect
+  enet_peer_disconnect_later(_peer, status);
+
+  _disconnecting = true;
+  _disconnectTime = std::chrono::steady_clock::now();
+}
+
+void Client::updateConnection() {
+  auto now = std::chrono::steady_clock::now();
+
+  if (_reconnecting && _client == nullptr) {
+    if (now >= _reconnectTime && openConnection() == false) {
+      connectionLost();
+    }
+
+    return;
+  }
+
+  if (_disconnecting) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - _disconnectTime).count();
+    if (elapsed >= (int64_t)_disconnectTimeout) {
+      ts3_log("Voice server did not confirm disconnect, resetting connection", LogLevel_DEBUG);
+      close();
+    }
+
+    return;
+  }
+
+  if (_state != CLIENT_STATE_CONNECTING) {
+    return;
+  }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - _connectTime).count();
+  if (elapsed >= (int64_t)_config.connectTimeout) {
+    ts3_log("Unable to connect to " + _host + ":" + std::to_string(_port), LogLevel_WARNING);
+    connectionLost();
+  }
+}
+
 void Client::update() {
   ENetEvent event;
+  uint32_t timeout = NETWORK_SERVICE_TIMEOUT;
+
+  while(_running) {
+    // sleep until the server sent something, a command got queued or the
+    // service timeout for ENet's resends and pings is reached. Without a host
+    // only commands wake up the thread, unless a reconnect is scheduled
+    if (_client != nullptr) {
+      _wakeup.wait(_client->socket, timeout);
+    } else {
+      _wakeup.wait(ENET_SOCKET_NULL, _reconnecting ? timeout : NETWORK_WAIT_INFINITE);
+    }
 
-  while(_running && _client != nullptr) {
-    int code = enet_host_service(_client, &event, 100);
-
-    if (code > 0) {
+    // handle all pending events without blocking
+    int code = 0;
+    while (_client != nullptr && (code = enet_host_service(_client, &event, 0)) > 0) {
       switch (event.type) {
-        case ENET_EVENT_TYPE_DISCONNECT:
-          ts3_log("Connection closed by the server", LogLevel_DEBUG);
+        case ENET_EVENT_TYPE_CONNECT:
+          ts3_log("Connection established", LogLevel_DEBUG);
 
+          // throttle settings are shared with the server, so only after connecting
+          enet_peer_throttle_configure(_peer, _config.throttleInterval, _config.throttleAcceleration, _config.throttleDeceleration);
+
+          setState(CLIENT_STATE_PROTOCOL);
+          sendProtocolMessage();
+          break;
+
+        case ENET_EVENT_TYPE_DISCONNECT:
           event.peer->data = NULL;
-          _running = false;
+
+          if (_disconnecting) {
+            ts3_log("Disconnected", LogLevel_INFO);
+            close();
+          } else if (isTimeout(event)) {
+            connectionLost();
+          } else {
+            ts3_log("Connection closed by the server", LogLevel_DEBUG);
+            close();
+          }
           break;
 
         case ENET_EVENT_TYPE_RECEIVE:
-          if (_running == false) {
-            enet_packet_destroy(event.packet);
-            break;
+          // handle message and delete payload afterwards, nothing is handled
+          // anymore while disconnecting
+          if (_disconnecting == false) {
+            handleMessage(event);
           }
 
-          // handle message and delete payload afterwards
-          handleMessage(event);
           enet_packet_destroy(event.packet);
           break;
 
         default:
           break;
       }
-    } else if (code < 0) {
+    }
+
+    if (code < 0) {
       ts3_log("Network error occured " + std::to_string(code), LogLevel_DEBUG);
-      _running = false;
+      connectionLost();
+    }
+
+    // ENet resets the peer before reporting its disconnect, keep its last activity
+    if (_peer != nullptr && _peer->lastReceiveTime != 0) {
+      _lastPeerActivity = _peer->lastReceiveTime;
     }
+
+    handleCommands();
+    updateConnection();
+    updateJoin();
+    timeout = updateStatus();
+
+    // send all messages queued during this tick right away
+    flushPackets();
+
+    if (_client != nullptr) {
+      enet_host_flush(_client);
+    }
+
+    updateStats();
   }
 
   close();
 }
 
+bool Client::isTimeout(ENetEvent &event) const {
+  // ENet reports timeouts like a disconnect without status. Acknowledgements
+  // of pings keep arriving on an idle connection, so a server closing it
+  // was heard from recently, while a timeout only happens after nothing
+  // arrived for at least the minimum timeout.
+  if (event.data != DISCONNECT_STATUS_OK) {
+    return false;
+  }
+
+  auto elapsed = ENET_TIME_DIFFERENCE(enet_time_get(), _lastPeerActivity);
+  return elapsed >= _config.timeoutMinimum;
+}
+
+void Client::updateStats() {
+  clientStats_t stats;
+  memset(&stats, 0, sizeof(stats));
+
+  stats.state = _state;
+  stats.capabilities = _capabilities;
+  stats.rejectedPackets = _rejectedPackets;
+  stats.reconnectAttempts = _reconnectAttempts;
+
+  // effective values after ENet applied its limits and the server's settings
+  if (_client != nullptr && _peer != nullptr) {
+    stats.roundTripTime = _peer->roundTripTime;
+    stats.packetLoss = _peer->packetLoss;
+    stats.mtu = _peer->mtu;
+    stats.incomingBandwidth = _client->incomingBandwidth;
+    stats.outgoingBandwidth = _client->outgoingBandwidth;
+    stats.throttleInterval = _peer->packetThrottleInterval;
+    stats.throttleAcceleration = _peer->packetThrottleAcceleration;
+    stats.throttleDeceleration = _peer->packetThrottleDeceleration;
+    stats.timeoutLimit = _peer->timeoutLimit;
+    stats.timeoutMinimum = _peer->timeoutMinimum;
+    stats.timeoutMaximum = _peer->timeoutMaximum;
+    stats.pingInterval = _peer->pingInterval;
+
+    stats.sentPackets = _client->totalSentPackets;
+    stats.receivedPackets = _client->totalReceivedPackets;
+    stats.sentBytes = _client->totalSentData;
+    stats.receivedBytes = _client->totalReceivedData;
+  }
+
+  ts3_positionCounters(&stats.appliedPositions, &stats.skippedPositions);
+
+  std::lock_guard<std::mutex> lock(_statsMutex);
+  _stats = stats;
+}
+
 void Client::abortThread() {
   // stop thread
   if (_thread == nullptr) {
@@ -275,6 +652,7 @@ void Client::abortThread() {
   if (_thread->get_id() != std::this_thread::get_id()) {
     if (_thread->joinable()) {
       _running = false;
+      _wakeup.signal();
       _thread->join();
     }
 
@@ -284,12 +662,49 @@ void Client::abortThread() {
   }
 }
 
+bool Client::enableCompression() {
+  if (_rangeCoder == nullptr) {
+    _rangeCoder = enet_range_coder_create();
+    if (_rangeCoder == nullptr) {
+      return false;
+    }
+  }
+
+  // ENet marks compressed datagrams, so decoding them can be enabled before the
+  // capability is agreed on without affecting servers not compressing at all
+  ENetCompressor compressor;
+  compressor.context = this;
+  compressor.compress = Client::compress;
+  compressor.decompress = Client::decompress;
+  compressor.destroy = NULL;
+
+  enet_host_compress(_client, &compressor);
+  return true;
+}
+
+size_t ENET_CALLBACK Client::compress(void *context, const ENetBuffer *inBuffers, size_t inBufferCount, size_t inLimit, enet_uint8 *outData, size_t outLimit) {
+  auto client = (Client *)context;
+
+  // zero sends the datagram uncompressed
+  if (client->_compressOutgoing == false) {
+    return 0;
+  }
+
+  return enet_range_coder_compress(client->_rangeCoder, inBuffers, inBufferCount, inLimit, outData, outLimit);
+}
+
+size_t ENET_CALLBACK Client::decompress(void *context, const enet_uint8 *inData, size_t inLimit, enet_uint8 *outData, size_t outLimit) {
+  auto client = (Client *)context;
+  return enet_range_coder_decompress(client->_rangeCoder, inData, inLimit, outData, outLimit);
+}
+
 void Client::sendProtocolMessage() {
   protocolPacket_t packet;
   packet.versionMajor = PROTOCOL_VERSION_MAJOR;
   packet.versionMinor = PROTOCOL_VERSION_MINOR;
   packet.minimumVersionMajor = PROTOCOL_MIN_VERSION_MAJOR;
   packet.minimumVersionMinor = PROTOCOL_MIN_VERSION_MINOR;
+  packet.capabilities = PROTOCOL_CLIENT_CAPABILITIES;
 
   // serialize payload
   bool result = false;
@@ -299,7 +714,7 @@ void Client::sendProtocolMessage() {
     return;
   }
 
-  sendPacket((void *)data.c_str(), data.size(), NETWORK_PROTOCOL_CHANNEL);
+  sendPacket(data, NETWORK_PROTOCOL_CHANNEL);
 }
 
 void Client::sendHandshake(int statusCode) {
@@ -310,6 +725,9 @@ void Client::sendHandshake(int statusCode) {
 
   packet.teamspeakClientUniqueIdentity = ts3_getClientIdentity();
 
+  // ask the server to resume the previous session after a lost connection
+  packet.resumptionToken = _reconnecting ? _resumptionToken : "";
+
   // serialize payload
   bool result = false;
   auto data = serializePacket<handshakePacket_t>(packet, &result);
@@ -318,14 +736,23 @@ void Client::sendHandshake(int statusCode) {
     return;
   }
 
-  sendPacket((void *)data.c_str(), data.size(), NETWORK_HANDSHAKE_CHANNEL);
+  sendPacket(data, NETWORK_HANDSHAKE_CHANNEL);
 }
 
 void Client::sendStatus() {
+  sendStatus(_talking, _microphoneMuted, _speakersMuted);
+}
+
+void Client::sendStatus(bool talking, bool microphoneMuted, bool speakersMuted) {
   statusPacket_t packet;
-  packet.talking = _talking;
-  packet.microphoneMuted = _microphoneMuted;
-  packet.speakersMuted = _speakersMuted;
+  packet.talking = talking;
+  packet.microphoneMuted = microphoneMuted;
+  packet.speakersMuted = speakersMuted;
+
+  _sentStatus = packet;
+  _hasSentStatus = true;
+  _hasPendingStatus = false;
+  _statusSentTime = std::chrono::steady_clock::now();
 
   // serialize payload
   bool result = false;
@@ -335,46 +762,57 @@ void Client::sendStatus() {
     return;
   }
 
-  sendPacket((void *)data.c_str(), data.size(), NETWORK_STATUS_CHANNEL);
+  sendPacket(data, NETWORK_STATUS_CHANNEL);
 }
 
-void Client::handleMessage(ENetEvent &event) {
-  switch (event.channelID) {
-    case NETWORK_PROTOCOL_CHANNEL:
-      handleProtocolResponse(event.packet);
-      break;
-
-    case NETWORK_HANDSHAKE_CHANNEL:
-      handleHandshakeResponse(event.packet);
-      break;
+void Client::sendPositionFrameAck(uint16_t keyframe) {
+  positionFrameAckPacket_t packet;
+  packet.keyframe = keyframe;
 
-    case NETWORK_UPDATE_CHANNEL:
-      handleUpdateMessage(event.packet);
-      break;
+  // serialize payload, acknowledgements do not need to be reliable
+  bool result = false;
+  auto data = serializePacket<positionFrameAckPacket_t>(packet, &result, 0);
+  if (result == false) {
+    ts3_log("Error serializing position frame acknowledgement", LogLevel_ERROR);
+    return;
+  }
 
-    case NETWORK_CONTROL_CHANNEL:
-      handleControlMessage(event.packet);
-      break;
+  sendPacket(data, NETWORK_POSITION_FRAME_CHANNEL);
+}
 
-    case NETWORK_POSITION_CHANNEL:
-      handlePositionMessage(event.packet);
-      break;
+void Client::handleMessage(ENetEvent &event) {
+  handleMessage(event.channelID, event.packet->data, event.packet->dataLength);
+}
 
-    default:
-      ts3_log("Unknown message on channel " + std::to_string(event.channelID), LogLevel_INFO);
-      break;
+void Client::handleMessage(int channelId, const void *data, size_t length) {
+  if (channelId < 0 || channelId >= NETWORK_CHANNELS) {
+    ts3_log("Unknown message on channel " + std::to_string(channelId), LogLevel_INFO);
+    return;
   }
+
+  dispatchChannel<Client, NETWORK_CHANNELS>(this, channelId, data, length);
 }
 
-void Client::handleProtocolResponse(ENetPacket *packet) {
+template <class T, void (Client::*handler)(T &)>
+void Client::dispatchPacket(const void *data, size_t length, const char *packetName) {
   // deserialize payload
   bool result = false;
-  auto protocolPacket = deserializePacket<protocolResponsePacket_t>(packet, &result);
+  auto packet = deserializePacket<T>(data, length, &result);
   if (result == false) {
-    ts3_log("Error deserializing protocol response packet", LogLevel_ERROR);
+    _rejectedPackets++;
+
+    ts3_log(std::string("Rejected malformed ") + packetName + " of " + std::to_string(length) + " bytes", LogLevel_ERROR);
     return;
   }
 
+  (this->*handler)(packet);
+}
+
+void Client::unexpectedPacket(int channelId) {
+  ts3_log("Unexpected message on channel " + std::to_string(channelId), LogLevel_INFO);
+}
+
+void Client::handleProtocolResponse(protocolResponsePacket_t &protocolPacket) {
   // compare protocol versions
   if (verifyProtocolVersion(protocolPacket.versionMajor, protocolPacket.versionMinor, PROTOCOL_MIN_VERSION_MAJOR, PROTOCOL_MIN_VERSION_MINOR) == false) {
     ts3_log("Server uses an outdated protocol version: " + std::to_string(protocolPacket.versionMajor) + "." + std::to_string(protocolPacket.versionMinor), LogLevel_WARNING);
@@ -390,21 +828,30 @@ void Client::handleProtocolResponse(ENetPacket *packet) {
     return;
   }
 
+  // enable all features supported by both sides
+  _capabilities = protocolPacket.capabilities & PROTOCOL_CLIENT_CAPABILITIES;
+  ts3_log("Agreed protocol capabilities " + std::to_string(_capabilities), LogLevel_DEBUG);
+
+  // compressed datagrams are decoded since the host was created, only start sending them now
+  if (_rangeCoder == nullptr) {
+    _capabilities &= ~PROTOCOL_CAPABILITY_COMPRESSION;
+  }
+
+  _compressOutgoing = hasCapability(PROTOCOL_CAPABILITY_COMPRESSION);
+
   // protocol matches, send handshake
+  setState(CLIENT_STATE_HANDSHAKE);
   sendHandshake();
 }
 
-void Client::handleHandshakeResponse(ENetPacket *packet) {
-  // deserialize payload
-  bool result = false;
-  auto responsePacket = deserializePacket<handshakeResponsePacket_t>(packet, &result);
-  if (result == false) {
-    ts3_log("Error deserializing handshake response packet", LogLevel_ERROR);
+void Client::handleHandshakeResponse(handshakeResponsePacket_t &responsePacket) {
+  if (responsePacket.statusCode != STATUS_CODE_OK) {
+    ts3_log("Handshake failed: " + std::to_string(responsePacket.statusCode) + ": " + responsePacket.reason , LogLevel_WARNING);
     return;
   }
 
-  if (responsePacket.statusCode != STATUS_CODE_OK) {
-    ts3_log("Handshake failed: " + std::to_string(responsePacket.statusCode) + ": " + responsePacket.reason , LogLevel_WARNING);
+  if (_joinStep != CLIENT_JOIN_NONE) {
+    ts3_log("Ignoring handshake response while joining the channel", LogLevel_DEBUG);
     return;
   }
 
@@ -414,48 +861,93 @@ void Client::handleHandshakeResponse(ENetPacket *packet) {
     return;
   }
 
-  // save old channel for later use
-  auto serverHandle =  ts3_serverConnectionHandle();
-  auto lastChannelId = ts3_channelId(serverHandle);
+  auto serverHandle = ts3_serverConnectionHandle();
+
+  if (_reconnecting && responsePacket.resumed && ts3_channelId(serverHandle) == responsePacket.channelId) {
+    resumeSession(responsePacket);
+    return;
+  }
 
-  bool tempMute = ts3_isOutputMuted(serverHandle) == false;
-  if (tempMute) {
-    ts3_setOutputMuted(serverHandle, true);
+  // save old channel for later use, a lost session keeps the one from before
+  _joinLastChannelId = _reconnecting && _lastChannelId != 0 ? _lastChannelId : ts3_channelId(serverHandle);
+  _joinChannelId = responsePacket.channelId;
+  _resumptionToken = responsePacket.resumptionToken;
+  _joinChannelPassword = responsePacket.channelPassword;
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  // keep the in-game channel silent until everybody in it is muted
+  _joinTempMute = ts3_isOutputMuted(serverHandle) == false;
+  if (_joinTempMute && ts3_setOutputMuted(serverHandle, true)) {
+    setJoinStep(CLIENT_JOIN_MUTING_OUTPUT);
+    return;
   }
-  
-  if (ts3_moveToChannel(responsePacket.channelId, responsePacket.channelPassword) == false) {
-    ts3_log(std::string("Unable to move into channel ") + std::to_string(responsePacket.channelId), LogLevel_WARNING);
-    sendHandshake(STATUS_CODE_NOT_MOVED_TO_CHANNEL);
+
+  moveToJoinChannel();
+}
+
+void Client::resumeSession(handshakeResponsePacket_t &responsePacket) {
+  // still in the in-game channel with everybody muted, nothing to redo
+  _resumptionToken = responsePacket.resumptionToken;
+  _reconnecting = false;
+  _reconnectAttempts = 0;
+
+  sendHandshake();
+  setState(CLIENT_STATE_INGAME);
+  ts3_log("Session resumed", LogLevel_INFO);
+
+  sendStatus();
+}
+
+void Client::setJoinStep(clientJoinStep_t step) {
+  _joinStep = step;
+  _joinStepTime = std::chrono::steady_clock::now();
+}
+
+void Client::moveToJoinChannel() {
+  if (ts3_channelId(ts3_serverConnectionHandle()) == _joinChannelId) {
+    finishJoin();
     return;
   }
 
+  if (ts3_moveToChannel(_joinChannelId, _joinChannelPassword) == false) {
+    ts3_log(std::string("Unable to move into channel ") + std::to_string(_joinChannelId), LogLevel_WARNING);
+    abortJoin(STATUS_CODE_NOT_MOVED_TO_CHANNEL);
+    return;
+  }
+
+  // wait for teamspeak to report the move of our own client
+  setJoinStep(CLIENT_JOIN_MOVING);
+}
+
+void Client::finishJoin() {
+  setJoinStep(CLIENT_JOIN_NONE);
+
   // mute all clients by default
   ts3_log("Muting all clients in channel", LogLevel_DEBUG);
 
-  auto clients = ts3_clientsInChannel(responsePacket.channelId);
-  for (auto it = clients.begin(); it != clients.end(); it++) {
-    ts3_muteClient(*it, true);
-  }
+  auto clients = ts3_clientsInChannel(_joinChannelId);
+  ts3_muteClients(clients, true);
 
-  if (tempMute) {
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  auto serverHandle = ts3_serverConnectionHandle();
 
+  if (_joinTempMute) {
     ts3_setOutputMuted(serverHandle, false);
+    _joinTempMute = false;
   }
 
   // if (ts3_muteClients(clients, true) == false) {
-  //   ts3_log("Unable to mute clients on joining channel " + std::to_string(responsePacket.channelId), LogLevel_WARNING);
+  //   ts3_log("Unable to mute clients on joining channel " + std::to_string(_joinChannelId), LogLevel_WARNING);
   //   sendHandshake(STATUS_CODE_UNABLE_TO_MUTE_CLIENTS);
   //   return;
   // }
 
   // connection on teamspeak server is valid, save teamspeak id
   _teamspeakId = ts3_clientId(serverHandle);
-  _lastChannelId = lastChannelId;
+  _lastChannelId = _joinLastChannelId;
+  _reconnecting = false;
+  _reconnectAttempts = 0;
 
   sendHandshake();
+  setState(CLIENT_STATE_INGAME);
   ts3_log("Handshake successful", LogLevel_DEBUG);
 
   // get initial sound status
@@ -468,77 +960,371 @@ void Client::handleHandshakeResponse(ENetPacket *packet) {
   ts3_set3DSettings(2.0f, 3.0f);
 }
 
-void Client::handleUpdateMessage(ENetPacket *packet) {
-  // deserialize payload
-  bool result = false;
-  auto updatePacket = deserializePacket<updatePacket_t>(packet, &result);
-  if (result == false) {
-    ts3_log("Error deserializing update packet", LogLevel_ERROR);
+void Client::abortJoin(int statusCode) {
+  setJoinStep(CLIENT_JOIN_NONE);
+
+  if (_joinTempMute) {
+    ts3_setOutputMuted(ts3_serverConnectionHandle(), false);
+    _joinTempMute = false;
+  }
+
+  sendHandshake(statusCode);
+}
+
+void Client::updateJoin() {
+  if (_joinStep == CLIENT_JOIN_NONE) {
     return;
   }
 
-  // handle volume changes
-  std::set<anyID> muteClients;
-  std::set<anyID> unmuteClients;
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _joinStepTime).count();
+  if (elapsed < CLIENT_JOIN_STEP_TIMEOUT) {
+    return;
+  }
+
+  // fall back to checking the state directly if an event got lost
+  switch (_joinStep) {
+    case CLIENT_JOIN_MUTING_OUTPUT:
+      ts3_log("Output mute not confirmed, joining anyway", LogLevel_DEBUG);
+      moveToJoinChannel();
+      break;
+
+    case CLIENT_JOIN_MOVING:
+      if (ts3_channelId(ts3_serverConnectionHandle()) == _joinChannelId) {
+        finishJoin();
+      } else {
+        ts3_log(std::string("Timed out moving into channel ") + std::to_string(_joinChannelId), LogLevel_WARNING);
+        abortJoin(STATUS_CODE_NOT_MOVED_TO_CHANNEL);
+      }
+      break;
+
+    default:
+      break;
+  }
+}
 
+void Client::handleUpdateMessage(updatePacket_t &updatePacket) {
+  // only the latest state per client is applied to teamspeak
   for (auto it = updatePacket.audioUpdates.begin(); it != updatePacket.audioUpdates.end(); it++) {
-    if ((*it).muted) {
-      ts3_log("Mute teamspeak user " + std::to_string((*it).teamspeakId), LogLevel_DEBUG);
+    _updater.setMuted((*it).teamspeakId, (*it).muted);
+  }
 
-      muteClients.insert((*it).teamspeakId);
-    } else {
-      ts3_log("Unmute teamspeak user " + std::to_string((*it).teamspeakId), LogLevel_DEBUG);
+  setPositions(updatePacket.positionUpdates);
+}
+
+void Client::handleControlMessage(controlPacket_t &controlPacket) {
+  // handle control packet
+  if (controlPacket.nickname.compare("") != 0) {
+    _updater.setNickname(controlPacket.nickname);
+  }
+}
+
+void Client::handlePositionMessage(positionPacket_t &positionPacket) {
+  // update all clients
+  setPositions(positionPacket.positions);
+}
+
+void Client::handlePositionFrameMessage(positionFramePacket_t &framePacket) {
+  // reconstruct all positions of this frame
+  positionTable_t positions;
+
+  if (framePacket.frameType == POSITION_FRAME_KEYFRAME) {
+    applyPositionFrame(positions, framePacket);
+
+    // keep keyframe as base for upcoming delta frames
+    for (auto it = _positionKeyframes.begin(); it != _positionKeyframes.end(); it++) {
+      if ((*it).first == framePacket.keyframe) {
+        _positionKeyframes.erase(it);
+        break;
+      }
+    }
 
-      unmuteClients.insert((*it).teamspeakId);
+    _positionKeyframes.push_back(std::make_pair(framePacket.keyframe, positions));
+    if (_positionKeyframes.size() > POSITION_KEYFRAME_HISTORY) {
+      _positionKeyframes.pop_front();
     }
+
+    sendPositionFrameAck(framePacket.keyframe);
+  } else {
+    auto keyframe = _positionKeyframes.end();
+    for (auto it = _positionKeyframes.begin(); it != _positionKeyframes.end(); it++) {
+      if ((*it).first == framePacket.keyframe) {
+        keyframe = it;
+        break;
+      }
+    }
+
+    if (keyframe == _positionKeyframes.end()) {
+      ts3_log("Dropping position delta for unknown keyframe " + std::to_string(framePacket.keyframe), LogLevel_DEBUG);
+      return;
+    }
+
+    positions = (*keyframe).second;
+
+    for (auto it = framePacket.removedIds.begin(); it != framePacket.removedIds.end(); it++) {
+      positions.erase(*it);
+    }
+
+    applyPositionFrame(positions, framePacket);
   }
 
-  ts3_muteClients(muteClients, true);
-  ts3_muteClients(unmuteClients, false);
+  // only update clients which moved since the last frame
+  std::vector<ts3ClientPosition_t> moved;
+  moved.reserve(positions.size());
 
-  // handle position changes
-  for (auto it = updatePacket.positionUpdates.begin(); it != updatePacket.positionUpdates.end(); it++) {
-    ts3_setClientPosition((*it).teamspeakId, (*it).x, (*it).y, (*it).z);
+  for (auto it = positions.begin(); it != positions.end(); it++) {
+    auto &position = (*it).second;
+
+    auto previous = _positionTable.find((*it).first);
+    if (previous != _positionTable.end() && (*previous).second.x == position.x && (*previous).second.y == position.y && (*previous).second.z == position.z) {
+      continue;
+    }
+
+    ts3ClientPosition_t update;
+    update.clientId = position.teamspeakId;
+    update.x = position.x;
+    update.y = position.y;
+    update.z = position.z;
+
+    moved.push_back(update);
   }
+
+  _updater.setPositions(moved);
+  _positionTable = std::move(positions);
 }
 
-void Client::handleControlMessage(ENetPacket *packet) {
-  // deserialize payload
-  bool result = false;
-  auto controlPacket = deserializePacket<controlPacket_t>(packet, &result);
-  if (result == false) {
-    ts3_log("Error deserializing control packet", LogLevel_ERROR);
-    return;
+void Client::setPositions(const std::vector<clientPositionUpdate_t> &positions) {
+  std::vector<ts3ClientPosition_t> updates;
+  updates.reserve(positions.size());
+
+  for (auto it = positions.begin(); it != positions.end(); it++) {
+    ts3ClientPosition_t update;
+    update.clientId = (*it).teamspeakId;
+    update.x = (*it).x;
+    update.y = (*it).y;
+    update.z = (*it).z;
+
+    updates.push_back(update);
   }
 
-  // handle control packet
-  if (controlPacket.nickname.compare("") != 0) {
-    ts3_setNickname(controlPacket.nickname);
+  _updater.setPositions(updates);
+}
+
+void Client::applyPositionFrame(positionTable_t &positions, positionFramePacket_t &framePacket) {
+  for (size_t i = 0; i < framePacket.teamspeakIds.size(); i++) {
+    clientPositionUpdate_t position;
+    position.teamspeakId = framePacket.teamspeakIds[i];
+    position.x = framePacket.positionsX[i];
+    position.y = framePacket.positionsY[i];
+    position.z = framePacket.positionsZ[i];
+    position.voiceRange = framePacket.voiceRanges[i];
+
+    positions[position.teamspeakId] = position;
   }
 }
 
-void Client::handlePositionMessage(ENetPacket *packet) {
-  // deserialize payload
-  bool result = false;
-  auto positionPacket = deserializePacket<positionPacket_t>(packet, &result);
-  if (result == false) {
-    ts3_log("Error deserializing position packet", LogLevel_ERROR);
-    return;
+void Client::handleBatchMessage(batchPacket_t &batchPacket) {
+  for (auto it = batchPacket.entries.begin(); it != batchPacket.entries.end(); it++) {
+    if ((*it).channelId == NETWORK_BATCH_CHANNEL) {
+      ts3_log("Skipping nested batch message", LogLevel_WARNING);
+      continue;
+    }
+
+    handleMessage((*it).channelId, (*it).data, (*it).length);
   }
+}
 
-  // update all clients
-  for (auto it = positionPacket.positions.begin(); it != positionPacket.positions.end(); it++) {
-    ts3_setClientPosition((*it).teamspeakId, (*it).x, (*it).y, (*it).z);
+bool Client::postCommand(clientCommandType_t type, uint64_t value) {
+  clientCommand_t command;
+  command.type = type;
+  command.value = value;
+  command.talking = false;
+  command.microphoneMuted = false;
+  command.speakersMuted = false;
+
+  if (_commands.push(command) == false) {
+    ts3_log("Command queue is full, dropping command " + std::to_string(type), LogLevel_WARNING);
+    return false;
   }
+
+  _wakeup.signal();
+  return true;
+}
+
+void Client::postStatus() {
+  clientCommand_t command;
+  command.type = CLIENT_COMMAND_STATUS;
+  command.value = 0;
+  command.talking = _talking;
+  command.microphoneMuted = _microphoneMuted;
+  command.speakersMuted = _speakersMuted;
+
+  // never block teamspeak threads, the network thread sends the latest
+  // status instead if the queue is full
+  if (_commands.push(command) == false) {
+    _droppedCommands = true;
+  }
+
+  _wakeup.signal();
 }
 
-void Client::sendPacket(void *data, size_t length, int channelId, bool reliable) {
-  enet_uint32 flags = 0;
+void Client::handleCommands() {
+  clientCommand_t command;
+
+  while (_commands.pop(command)) {
+    switch (command.type) {
+      case CLIENT_COMMAND_STATUS:
+        queueStatus(command.talking, command.microphoneMuted, command.speakersMuted);
+
+        if (_joinStep == CLIENT_JOIN_MUTING_OUTPUT && command.speakersMuted) {
+          moveToJoinChannel();
+        }
+        break;
+
+      case CLIENT_COMMAND_OWN_CLIENT_MOVED:
+        if (_joinStep == CLIENT_JOIN_MOVING && command.value == _joinChannelId) {
+          finishJoin();
+        }
+        break;
+
+      case CLIENT_COMMAND_CONNECT:
+        startConnection();
+        break;
+
+      case CLIENT_COMMAND_DISCONNECT:
+        startDisconnect((uint32_t)command.value);
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  if (_droppedCommands.exchange(false)) {
+    ts3_log("Command queue overflowed, sending latest status", LogLevel_DEBUG);
+    queueStatus(_talking, _microphoneMuted, _speakersMuted);
+  }
+}
+
+void Client::queueStatus(bool talking, bool microphoneMuted, bool speakersMuted) {
+  // only the latest status is kept until it is sent
+  _pendingStatus.talking = talking;
+  _pendingStatus.microphoneMuted = microphoneMuted;
+  _pendingStatus.speakersMuted = speakersMuted;
+  _hasPendingStatus = true;
+}
+
+uint32_t Client::updateStatus() {
+  if (_hasPendingStatus == false) {
+    return NETWORK_SERVICE_TIMEOUT;
+  }
+
+  // the handshake sends the current status once in-game
+  if (_state != CLIENT_STATE_INGAME || _disconnecting) {
+    _hasPendingStatus = false;
+    return NETWORK_SERVICE_TIMEOUT;
+  }
+
+  // drop changes which were reverted before being sent, e.g. voice activation flapping
+  if (_hasSentStatus && _pendingStatus.talking == _sentStatus.talking && _pendingStatus.microphoneMuted == _sentStatus.microphoneMuted && _pendingStatus.speakersMuted == _sentStatus.speakersMuted) {
+    _hasPendingStatus = false;
+    return NETWORK_SERVICE_TIMEOUT;
+  }
+
+  // the first change after an idle period is sent right away, later ones
+  // at most once per interval
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _statusSentTime).count();
+  uint32_t interval = _statusInterval;
+
+  if (_hasSentStatus == false || elapsed >= (int64_t)interval) {
+    sendStatus(_pendingStatus.talking, _pendingStatus.microphoneMuted, _pendingStatus.speakersMuted);
+    return NETWORK_SERVICE_TIMEOUT;
+  }
+
+  // wake up again once the pending status may be sent
+  return std::min((uint32_t)(interval - elapsed), (uint32_t)NETWORK_SERVICE_TIMEOUT);
+}
+
+void Client::sendPacket(ENetPacket *packet, int channelId) {
+  // only called from the network thread
+  _pendingPackets.push_back(std::make_pair(channelId, packet));
+}
+
+void Client::sendPacketNow(ENetPacket *packet, int channelId) {
+  // packet is only owned by the peer if it was queued successfully
+  if (_peer == nullptr || enet_peer_send(_peer, (enet_uint8)channelId, packet) < 0) {
+    enet_packet_destroy(packet);
+  }
+}
+
+void Client::flushPackets() {
+  std::vector<std::pair<int, ENetPacket *>> packets;
+  packets.swap(_pendingPackets);
+
+  if (packets.empty()) {
+    return;
+  }
+
+  // unreliable messages keep their own channel, inside the reliable batch they
+  // would wait for lost datagrams to be resent
+  std::vector<std::pair<int, ENetPacket *>> reliablePackets;
+  reliablePackets.reserve(packets.size());
+
+  for (auto it = packets.begin(); it != packets.end(); it++) {
+    if (((*it).second->flags & ENET_PACKET_FLAG_RELIABLE) == 0) {
+      sendPacketNow((*it).second, (*it).first);
+    } else {
+      reliablePackets.push_back(*it);
+    }
+  }
+
+  if (reliablePackets.empty()) {
+    return;
+  }
+
+  // the protocol message is needed to agree on batching in the first place.
+  // Afterwards even a single message goes through the batch channel, ENet
+  // only orders packets per channel and it must not overtake an earlier batch
+  if (hasCapability(PROTOCOL_CAPABILITY_BATCHING) == false) {
+    for (auto it = reliablePackets.begin(); it != reliablePackets.end(); it++) {
+      sendPacketNow((*it).second, (*it).first);
+    }
+
+    return;
+  }
+
+  batchPacket_t batchPacket;
+
+  for (auto it = reliablePackets.begin(); it != reliablePackets.end(); it++) {
+    batchEntry_t entry;
+    entry.channelId = (uint8_t)(*it).first;
+    entry.length = (uint32_t)(*it).second->dataLength;
+    entry.data = (*it).second->data;
+
+    batchPacket.entries.push_back(entry);
+  }
+
+  bool result = false;
+  auto data = serializePacket<batchPacket_t>(batchPacket, &result, ENET_PACKET_FLAG_RELIABLE);
+
+  if (result) {
+    sendPacketNow(data, NETWORK_BATCH_CHANNEL);
+
+    for (auto it = reliablePackets.begin(); it != reliablePackets.end(); it++) {
+      enet_packet_destroy((*it).second);
+    }
+  } else {
+    ts3_log("Error serializing batch packet, sending messages separately", LogLevel_WARNING);
+
+    for (auto it = reliablePackets.begin(); it != reliablePackets.end(); it++) {
+      sendPacketNow((*it).second, (*it).first);
+    }
+  }
+}
 
-  if (reliable) {
-    flags |= ENET_PACKET_FLAG_RELIABLE;
+void Client::discardPendingPackets() {
+  for (auto it = _pendingPackets.begin(); it != _pendingPackets.end(); it++) {
+    enet_packet_destroy((*it).second);
   }
 
-  auto packet = enet_packet_create(data, length, flags);
-  enet_peer_send(_peer, (enet_uint8)channelId, packet);
+  _pendingPackets.clear();
 }
@@ -0,0 +1,202 @@
+/*
+ * File: src/config.cpp
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <fstream>
+#include <sstream>
+#include <errno.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <enet/enet.h>
+
+#include "client.h"
+#include "teamspeak.h"
+
+// longest timeout or interval accepted from the config file (in ms)
+#define CONFIG_MAXIMUM_DURATION 600000
+
+// largest position epsilon accepted from the config file (in mm)
+#define CONFIG_MAXIMUM_POSITION_EPSILON 1000
+
+typedef struct {
+  const char *name;
+  uint32_t clientConfig_t::*value;
+  uint32_t minimum;
+  uint32_t maximum;
+} configEntry_t;
+
+static const configEntry_t _entries[] = {
+  { "incoming_bandwidth", &clientConfig_t::incomingBandwidth, 0, UINT32_MAX },
+  { "outgoing_bandwidth", &clientConfig_t::outgoingBandwidth, 0, UINT32_MAX },
+  { "mtu", &clientConfig_t::mtu, ENET_PROTOCOL_MINIMUM_MTU, ENET_PROTOCOL_MAXIMUM_MTU },
+  { "throttle_interval", &clientConfig_t::throttleInterval, 1, CONFIG_MAXIMUM_DURATION },
+  { "throttle_acceleration", &clientConfig_t::throttleAcceleration, 1, ENET_PEER_PACKET_THROTTLE_SCALE },
+  { "throttle_deceleration", &clientConfig_t::throttleDeceleration, 1, ENET_PEER_PACKET_THROTTLE_SCALE },
+  { "timeout_limit", &clientConfig_t::timeoutLimit, 1, 1024 },
+  { "timeout_minimum", &clientConfig_t::timeoutMinimum, 1, CONFIG_MAXIMUM_DURATION },
+  { "timeout_maximum", &clientConfig_t::timeoutMaximum, 1, CONFIG_MAXIMUM_DURATION },
+  { "ping_interval", &clientConfig_t::pingInterval, 1, CONFIG_MAXIMUM_DURATION },
+  { "connect_timeout", &clientConfig_t::connectTimeout, 1, CONFIG_MAXIMUM_DURATION },
+  { "disconnect_timeout", &clientConfig_t::disconnectTimeout, 1, CONFIG_MAXIMUM_DURATION },
+  { "status_interval", &clientConfig_t::statusInterval, 1, CONFIG_MAXIMUM_DURATION },
+  { "position_epsilon", &clientConfig_t::positionEpsilon, 0, CONFIG_MAXIMUM_POSITION_EPSILON }
+};
+
+static std::string trim(const std::string &value) {
+  auto start = value.find_first_not_of(" \t\r\n");
+  if (start == std::string::npos) {
+    return "";
+  }
+
+  auto end = value.find_last_not_of(" \t\r\n");
+  return value.substr(start, end - start + 1);
+}
+
+static bool parseValue(const std::string &value, uint32_t *result) {
+  // strtoul skips whitespace and accepts signs, negative values would wrap
+  if (value.empty() || isdigit((unsigned char)value[0]) == 0) {
+    return false;
+  }
+
+  char *end = nullptr;
+  errno = 0;
+  auto parsed = strtoul(value.c_str(), &end, 10);
+
+  if (errno == ERANGE || end != value.c_str() + value.size()) {
+    return false;
+  }
+
+  if (parsed > UINT32_MAX) {
+    return false;
+  }
+
+  *result = (uint32_t)parsed;
+  return true;
+}
+
+clientConfig_t config_defaults() {
+  clientConfig_t config;
+  config.incomingBandwidth = 0;
+  config.outgoingBandwidth = 0;
+  config.mtu = ENET_HOST_DEFAULT_MTU;
+
+  config.throttleInterval = ENET_PEER_PACKET_THROTTLE_INTERVAL;
+  config.throttleAcceleration = ENET_PEER_PACKET_THROTTLE_ACCELERATION;
+  config.throttleDeceleration = ENET_PEER_PACKET_THROTTLE_DECELERATION;
+
+  config.timeoutLimit = ENET_PEER_TIMEOUT_LIMIT;
+  config.timeoutMinimum = CLIENT_PEER_TIMEOUT_MINIMUM;
+  config.timeoutMaximum = CLIENT_PEER_TIMEOUT_MAXIMUM;
+  config.pingInterval = ENET_PEER_PING_INTERVAL;
+
+  config.connectTimeout = CLIENT_CONNECT_TIMEOUT;
+  config.disconnectTimeout = CLIENT_DISCONNECT_TIMEOUT;
+  config.statusInterval = CLIENT_STATUS_INTERVAL;
+  config.positionEpsilon = TEAMSPEAK_POSITION_EPSILON;
+
+  return config;
+}
+
+bool config_load(std::string path, clientConfig_t *config) {
+  std::ifstream file(path);
+  if (file.is_open() == false) {
+    return false;
+  }
+
+  // simple ini format, sections are only used for grouping
+  std::string line;
+  int lineNumber = 0;
+
+  while (std::getline(file, line)) {
+    lineNumber++;
+    line = trim(line);
+
+    if (line.empty() || line[0] == '#' || line[0] == ';' || line[0] == '[') {
+      continue;
+    }
+
+    auto separator = line.find('=');
+    if (separator == std::string::npos) {
+      ts3_log("Invalid config line " + std::to_string(lineNumber) + " in " + path, LogLevel_WARNING);
+      continue;
+    }
+
+    auto name = trim(line.substr(0, separator));
+    auto value = trim(line.substr(separator + 1));
+
+    bool found = false;
+    for (auto &entry : _entries) {
+      if (name.compare(entry.name) != 0) {
+        continue;
+      }
+
+      found = true;
+
+      uint32_t parsed = 0;
+      if (parseValue(value, &parsed) == false || parsed < entry.minimum || parsed > entry.maximum) {
+        ts3_log("Invalid value for " + name + " in " + path + ", expected " + std::to_string(entry.minimum) + " to " + std::to_string(entry.maximum), LogLevel_WARNING);
+        break;
+      }
+
+      (*config).*entry.value = parsed;
+      break;
+    }
+
+    if (found == false) {
+      ts3_log("Unknown config key " + name + " in " + path, LogLevel_WARNING);
+    }
+  }
+
+  // peers time out between the two limits and have to ping more often
+  auto defaults = config_defaults();
+
+  if (config->timeoutMinimum > config->timeoutMaximum) {
+    ts3_log("timeout_minimum exceeds timeout_maximum in " + path + ", using defaults", LogLevel_WARNING);
+    config->timeoutMinimum = defaults.timeoutMinimum;
+    config->timeoutMaximum = defaults.timeoutMaximum;
+  }
+
+  if (config->pingInterval >= config->timeoutMinimum) {
+    ts3_log("ping_interval has to be below timeout_minimum in " + path + ", using defaults", LogLevel_WARNING);
+    config->pingInterval = defaults.pingInterval;
+    config->timeoutMinimum = defaults.timeoutMinimum;
+    config->timeoutMaximum = defaults.timeoutMaximum;
+  }
+
+  return true;
+}
+
+std::string config_toString(const clientConfig_t &config) {
+  std::ostringstream stream;
+
+  for (auto &entry : _entries) {
+    stream << entry.name << "=" << config.*entry.value << "\n";
+  }
+
+  return stream.str();
+}
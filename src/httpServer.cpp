@@ -72,7 +72,11 @@ bool HttpServer::isOpen() const {
   return _daemon != nullptr;
 }
 
-int HttpServer::handleRequest(struct MHD_Connection *connection, const char *, const char *, const char *, size_t *) {
+int HttpServer::handleRequest(struct MHD_Connection *connection, const char *url, const char *, const char *, size_t *) {
+  if (url != NULL && strcmp(url, "/stats") == 0) {
+    return handleStatsRequest(connection);
+  }
+
   if (_connectionMutex.try_lock() == false) {
     const char *page = "<html><body>Already connecting</body></html>";
     return sendResponse(connection, page, MHD_HTTP_IM_USED);
@@ -109,20 +113,46 @@ int HttpServer::handleRequest(struct MHD_Connection *connection, const char *, c
   }
 
   ts3_log(std::string("Connect: ") + host + ":" + port, LogLevel_INFO);
-  if (JustAnotherVoiceChat_connect(std::string(host), (uint16_t)std::stoi(port), (uint16_t)std::stoi(uniqueIdentifier)) == false) {
-    _connectionMutex.unlock();
+  bool started = JustAnotherVoiceChat_connect(std::string(host), (uint16_t)std::stoi(port), (uint16_t)std::stoi(uniqueIdentifier));
+
+  // connecting continues on the network thread, retries may come in while waiting
+  _connectionMutex.unlock();
+
+  // an older connection may still be open when the attempt was not queued
+  if (started == false) {
+    const char *page = "<html><body>Unable to start connecting</body></html>";
+    return sendResponse(connection, page, MHD_HTTP_SERVICE_UNAVAILABLE);
+  }
+
+  if (JustAnotherVoiceChat_waitForConnection(HTTP_CONNECT_TIMEOUT) == false) {
+    if (JustAnotherVoiceChat_isConnecting()) {
+      const char *page = "<html><body>Connecting</body></html>";
+      return sendResponse(connection, page, MHD_HTTP_ACCEPTED);
+    }
 
     const char *page = "<html><body>Unable to connect</body></html>";
     return sendResponse(connection, page, MHD_HTTP_BAD_REQUEST);
   }
 
-  _connectionMutex.unlock();
-
   // send response
   const char *page = "<html><body>OK</body></html>";
   return sendResponse(connection, page);
 }
 
+int HttpServer::handleStatsRequest(struct MHD_Connection *connection) {
+  return sendResponse(connection, JustAnotherVoiceChat_stats(), "text/plain");
+}
+
+int HttpServer::sendResponse(struct MHD_Connection *connection, const std::string &content, const char *contentType, unsigned int statusCode) {
+  auto response = MHD_create_response_from_buffer(content.size(), (void *)content.c_str(), MHD_RESPMEM_MUST_COPY);
+  MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_TYPE, contentType);
+
+  int result = MHD_queue_response(connection, statusCode, response);
+
+  MHD_destroy_response(response);
+  return result;
+}
+
 int HttpServer::sendResponse(struct MHD_Connection *connection, const char *page, unsigned int statusCode) {
   auto response = MHD_create_response_from_buffer(strlen(page), (void *)page, MHD_RESPMEM_PERSISTENT);
   
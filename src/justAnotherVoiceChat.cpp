@@ -28,6 +28,7 @@
 #include "justAnotherVoiceChat.h"
 
 #include <iostream>
+#include <sstream>
 #include <enet/enet.h>
 
 #ifdef _WIN32
@@ -39,6 +40,7 @@
 #include "httpServer.h"
 #include "teamspeak.h"
 #include "client.h"
+#include "config.h"
 
 HttpServer *httpServer = nullptr;
 Client *client = nullptr;
@@ -63,7 +65,17 @@ bool JustAnotherVoiceChat_start() {
     delete client;
   }
 
-  client = new Client();
+  // settings not found in the config file keep their defaults
+  auto config = config_defaults();
+  auto configPath = ts3_getConfigPath() + CONFIG_FILE_NAME;
+
+  if (config_load(configPath, &config)) {
+    ts3_log("Loaded config " + configPath, LogLevel_INFO);
+  } else {
+    ts3_log("No config found at " + configPath + ", using defaults", LogLevel_DEBUG);
+  }
+
+  client = new Client(config);
   
   httpServer = new HttpServer();
   httpServer->open(HTTP_PORT);
@@ -102,6 +114,23 @@ bool JustAnotherVoiceChat_connect(std::string host, uint16_t port, uint16_t uniq
   return true;
 }
 
+bool JustAnotherVoiceChat_waitForConnection(uint32_t timeout) {
+  if (client == nullptr) {
+    return false;
+  }
+
+  // connected as soon as the voice server accepted the connection
+  return client->waitForState(CLIENT_STATE_PROTOCOL, timeout);
+}
+
+bool JustAnotherVoiceChat_isConnecting() {
+  if (client == nullptr) {
+    return false;
+  }
+
+  return client->isOpen() && client->isIngame() == false;
+}
+
 void JustAnotherVoiceChat_disconnect() {
   if (client == nullptr) {
     return;
@@ -110,6 +139,22 @@ void JustAnotherVoiceChat_disconnect() {
   client->disconnect();
 }
 
+void JustAnotherVoiceChat_ownClientMoved(uint64_t channelId) {
+  if (client == nullptr || client->isOpen() == false) {
+    return;
+  }
+
+  client->ownClientMoved(channelId);
+}
+
+void JustAnotherVoiceChat_forgetClient(uint16_t clientId) {
+  if (client == nullptr) {
+    return;
+  }
+
+  client->forgetClient(clientId);
+}
+
 void JustAnotherVoiceChat_updateTalking(bool talking) {
   if (client == nullptr || client->isOpen() == false) {
     return;
@@ -134,6 +179,50 @@ void JustAnotherVoiceChat_updateSpeakersMute(bool muted) {
   client->setSpeakersMuted(muted);
 }
 
+std::string JustAnotherVoiceChat_stats() {
+  if (client == nullptr) {
+    return "";
+  }
+
+  auto stats = client->stats();
+
+  std::ostringstream stream;
+  stream << "[client]\n";
+  stream << "state=" << stats.state << "\n";
+  stream << "capabilities=" << stats.capabilities << "\n";
+  stream << "rejected_packets=" << stats.rejectedPackets << "\n";
+  stream << "reconnect_attempts=" << stats.reconnectAttempts << "\n";
+  stream << "status_interval=" << client->statusInterval() << "\n";
+  stream << "disconnect_timeout=" << client->disconnectTimeout() << "\n";
+
+  stream << "\n[connection]\n";
+  stream << "round_trip_time=" << stats.roundTripTime << "\n";
+  stream << "packet_loss=" << stats.packetLoss << "\n";
+  stream << "mtu=" << stats.mtu << "\n";
+  stream << "incoming_bandwidth=" << stats.incomingBandwidth << "\n";
+  stream << "outgoing_bandwidth=" << stats.outgoingBandwidth << "\n";
+  stream << "throttle_interval=" << stats.throttleInterval << "\n";
+  stream << "throttle_acceleration=" << stats.throttleAcceleration << "\n";
+  stream << "throttle_deceleration=" << stats.throttleDeceleration << "\n";
+  stream << "timeout_limit=" << stats.timeoutLimit << "\n";
+  stream << "timeout_minimum=" << stats.timeoutMinimum << "\n";
+  stream << "timeout_maximum=" << stats.timeoutMaximum << "\n";
+  stream << "ping_interval=" << stats.pingInterval << "\n";
+  stream << "sent_packets=" << stats.sentPackets << "\n";
+  stream << "received_packets=" << stats.receivedPackets << "\n";
+  stream << "sent_bytes=" << stats.sentBytes << "\n";
+  stream << "received_bytes=" << stats.receivedBytes << "\n";
+
+  stream << "\n[teamspeak]\n";
+  stream << "applied_positions=" << stats.appliedPositions << "\n";
+  stream << "skipped_positions=" << stats.skippedPositions << "\n";
+
+  stream << "\n[config]\n";
+  stream << config_toString(client->config());
+
+  return stream.str();
+}
+
 bool JustAnotherVoiceChat_isIngame() {
   if (client == nullptr || client->isOpen() == false) {
     return false;
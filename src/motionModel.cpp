@@ -0,0 +1,149 @@
+/*
+ * File: src/motionModel.cpp
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "motionModel.h"
+
+#include <algorithm>
+
+MotionModel::MotionModel() {
+  _latest.x = _latest.y = _latest.z = 0;
+  _start = _latest;
+  _velocity = _latest;
+  _rendered = _latest;
+  _delay = 0;
+  _hasSample = false;
+  _hasRendered = false;
+}
+
+void MotionModel::reset(const clientPosition_t &position, motionTime_t time) {
+  _start = position;
+  _latest = position;
+  _latestTime = time;
+  _velocity.x = _velocity.y = _velocity.z = 0;
+  _delay = 0;
+  _hasSample = true;
+}
+
+void MotionModel::addSample(motionTime_t time, const clientPosition_t &position) {
+  if (_hasSample == false) {
+    reset(position, time);
+    return;
+  }
+
+  double elapsed = std::chrono::duration<double, std::milli>(time - _latestTime).count();
+
+  // jumps are not smoothed, they would overshoot by the jump distance
+  double dx = position.x - _latest.x;
+  double dy = position.y - _latest.y;
+  double dz = position.z - _latest.z;
+  double maxDistance = MOTION_MAX_SPEED * std::max(elapsed, (double)MOTION_MIN_SAMPLE_INTERVAL) / 1000.0;
+
+  if (dx * dx + dy * dy + dz * dz > maxDistance * maxDistance) {
+    reset(position, time);
+    return;
+  }
+
+  // samples of the same tick only replace the target
+  if (elapsed < MOTION_MIN_SAMPLE_INTERVAL) {
+    _latest = position;
+    return;
+  }
+
+  // continue from the currently rendered position to avoid jumps
+  _start = positionAt(time);
+
+  _velocity.x = (float)((position.x - _latest.x) / elapsed);
+  _velocity.y = (float)((position.y - _latest.y) / elapsed);
+  _velocity.z = (float)((position.z - _latest.z) / elapsed);
+  _latest = position;
+  _latestTime = time;
+  _delay = std::min(elapsed, (double)MOTION_MAX_INTERPOLATION_DELAY);
+}
+
+clientPosition_t MotionModel::positionAt(motionTime_t time) const {
+  double elapsed = std::chrono::duration<double, std::milli>(time - _latestTime).count();
+
+  // interpolate towards the latest sample
+  if (_hasSample && elapsed < _delay) {
+    double factor = std::max(0.0, elapsed / _delay);
+
+    clientPosition_t position;
+    position.x = (float)(_start.x + (_latest.x - _start.x) * factor);
+    position.y = (float)(_start.y + (_latest.y - _start.y) * factor);
+    position.z = (float)(_start.z + (_latest.z - _start.z) * factor);
+
+    return position;
+  }
+
+  // extrapolate along the last velocity for short gaps, then return to the
+  // latest sample as the client most likely stopped there
+  double extrapolation = std::max(0.0, elapsed - _delay);
+
+  if (extrapolation >= MOTION_MAX_EXTRAPOLATION + MOTION_RETURN_DURATION) {
+    return _latest;
+  }
+
+  if (extrapolation > MOTION_MAX_EXTRAPOLATION) {
+    double remaining = 1.0 - (extrapolation - MOTION_MAX_EXTRAPOLATION) / MOTION_RETURN_DURATION;
+    extrapolation = MOTION_MAX_EXTRAPOLATION * remaining;
+  }
+
+  clientPosition_t position;
+  position.x = (float)(_latest.x + _velocity.x * extrapolation);
+  position.y = (float)(_latest.y + _velocity.y * extrapolation);
+  position.z = (float)(_latest.z + _velocity.z * extrapolation);
+
+  return position;
+}
+
+bool MotionModel::isSettled(motionTime_t time) const {
+  if (_hasSample == false) {
+    return true;
+  }
+
+  double elapsed = std::chrono::duration<double, std::milli>(time - _latestTime).count();
+  if (elapsed < _delay) {
+    return false;
+  }
+
+  // standing still at the latest sample or returned to it after extrapolating
+  bool stationary = _velocity.x == 0 && _velocity.y == 0 && _velocity.z == 0;
+  return stationary || elapsed - _delay >= MOTION_MAX_EXTRAPOLATION + MOTION_RETURN_DURATION;
+}
+
+bool MotionModel::render(motionTime_t time, clientPosition_t *position) {
+  *position = positionAt(time);
+
+  if (_hasRendered && position->x == _rendered.x && position->y == _rendered.y && position->z == _rendered.z) {
+    return false;
+  }
+
+  _rendered = *position;
+  _hasRendered = true;
+
+  return true;
+}
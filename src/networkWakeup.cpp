@@ -0,0 +1,151 @@
+/*
+ * File: src/networkWakeup.cpp
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "networkWakeup.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/select.h>
+#endif
+
+NetworkWakeup::NetworkWakeup() {
+  _socket = ENET_SOCKET_NULL;
+  _address.host = ENET_HOST_ANY;
+  _address.port = 0;
+}
+
+NetworkWakeup::~NetworkWakeup() {
+  close();
+}
+
+bool NetworkWakeup::open() {
+  if (_socket != ENET_SOCKET_NULL) {
+    return true;
+  }
+
+  _socket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+  if (_socket == ENET_SOCKET_NULL) {
+    return false;
+  }
+
+  // bind to a random loopback port and remember it to send to ourselves
+  ENetAddress address;
+  address.port = 0;
+
+  if (enet_address_set_host(&address, "127.0.0.1") != 0 || enet_socket_bind(_socket, &address) != 0 || enet_socket_get_address(_socket, &_address) != 0) {
+    close();
+    return false;
+  }
+
+  enet_socket_set_option(_socket, ENET_SOCKOPT_NONBLOCK, 1);
+  return true;
+}
+
+void NetworkWakeup::close() {
+  if (_socket == ENET_SOCKET_NULL) {
+    return;
+  }
+
+  enet_socket_destroy(_socket);
+  _socket = ENET_SOCKET_NULL;
+}
+
+bool NetworkWakeup::isOpen() const {
+  return _socket != ENET_SOCKET_NULL;
+}
+
+void NetworkWakeup::signal() {
+  if (_socket == ENET_SOCKET_NULL) {
+    return;
+  }
+
+  uint8_t data = 1;
+
+  ENetBuffer buffer;
+  buffer.data = &data;
+  buffer.dataLength = sizeof(data);
+
+  enet_socket_send(_socket, &_address, &buffer, 1);
+}
+
+bool NetworkWakeup::wait(ENetSocket socket, uint32_t timeout) {
+  // nothing could wake us without a socket
+  if (socket == ENET_SOCKET_NULL && _socket == ENET_SOCKET_NULL) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(std::min(timeout, (uint32_t)NETWORK_SERVICE_TIMEOUT)));
+    return false;
+  }
+
+  ENetSocketSet readSet;
+  ENET_SOCKETSET_EMPTY(readSet);
+
+  ENetSocket maxSocket = ENET_SOCKET_NULL;
+
+  if (socket != ENET_SOCKET_NULL) {
+    ENET_SOCKETSET_ADD(readSet, socket);
+    maxSocket = socket;
+  }
+
+  if (_socket != ENET_SOCKET_NULL) {
+    ENET_SOCKETSET_ADD(readSet, _socket);
+    maxSocket = maxSocket == ENET_SOCKET_NULL ? _socket : std::max(maxSocket, _socket);
+  }
+
+  // ENet's select always sleeps for a limited time, ENetSocketSet is an fd_set
+  // on all platforms though
+  int result;
+  if (timeout == NETWORK_WAIT_INFINITE) {
+    result = select((int)maxSocket + 1, &readSet, NULL, NULL, NULL);
+  } else {
+    result = enet_socketset_select(maxSocket, &readSet, NULL, timeout);
+  }
+
+  if (result <= 0) {
+    return false;
+  }
+
+  if (_socket != ENET_SOCKET_NULL && ENET_SOCKETSET_CHECK(readSet, _socket)) {
+    drain();
+  }
+
+  return true;
+}
+
+void NetworkWakeup::drain() {
+  uint8_t data[16];
+
+  ENetBuffer buffer;
+  buffer.data = data;
+  buffer.dataLength = sizeof(data);
+
+  // multiple signals are handled by a single wakeup
+  ENetAddress address;
+  while (enet_socket_receive(_socket, &address, &buffer, 1) > 0) {
+  }
+}
@@ -30,20 +30,72 @@
 #include "teamspeakPlugin.h"
 
 #include <stdlib.h>
-#include <thread>
+#include <string.h>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <unordered_map>
 #include <chrono>
 #include <teamspeak/public_rare_definitions.h>
 
 #define BUFFER_LENGTH 256
+#define MUTE_TABLE_WORDS (65536 / 64)
 
 static uint64 _serverConnectionHandler = 0;
-static std::set<anyID> _mutedClients;
+// one bit per anyID for every client muted by us
+static uint64_t _mutedClients[MUTE_TABLE_WORDS];
+static std::mutex _muteMutex;
+
+// last position applied to teamspeak per client
+static std::unordered_map<anyID, TS3_VECTOR> _clientPositions;
+static std::mutex _positionMutex;
+static float _positionEpsilon = TEAMSPEAK_POSITION_EPSILON / 1000.0f;
+static std::atomic<uint64_t> _appliedPositions(0);
+static std::atomic<uint64_t> _skippedPositions(0);
+
+// own client and channel per server connection, zero until requested
+typedef struct {
+  anyID clientId;
+  uint64 channelId;
+} ownClient_t;
+
+static std::unordered_map<uint64, ownClient_t> _ownClients;
+static std::mutex _ownClientMutex;
+static uint64_t _ownClientEvents = 0;
+
+// channel subscription events signaled by teamspeak
+static std::mutex _subscriptionMutex;
+static std::condition_variable _subscriptionCondition;
+static uint64_t _subscriptionEvents = 0;
+
+// clients per channel of the verified server, only holds fetched channels
+static std::unordered_map<uint64, std::set<anyID>> _channelMembers;
+static std::mutex _memberMutex;
+static uint64_t _memberEvents = 0;
 static std::string _originalNickname = "";
 
 void ts3_log(std::string message, enum LogLevel severity) {
   ts3Functions.logMessage(message.c_str(), severity, "JustAnotherVoiceChat", 0);
 }
 
+std::string ts3_getConfigPath() {
+  char path[BUFFER_LENGTH];
+  ts3Functions.getConfigPath(path, BUFFER_LENGTH);
+
+  return std::string(path);
+}
+
+static void forgetClients() {
+  {
+    std::lock_guard<std::mutex> lock(_muteMutex);
+    memset(_mutedClients, 0, sizeof(_mutedClients));
+  }
+
+  std::lock_guard<std::mutex> lock(_positionMutex);
+  _clientPositions.clear();
+}
+
 bool ts3_verifyServer(std::string uniqueIdentifier) {
   // check if server is already connected
   uint64 *serverList;
@@ -58,6 +110,15 @@ bool ts3_verifyServer(std::string uniqueIdentifier) {
   uint64 handle = serverList[index];
   _serverConnectionHandler = 0;
 
+  // mutes, positions and members of another server connection are unknown to this one
+  forgetClients();
+
+  {
+    std::lock_guard<std::mutex> lock(_memberMutex);
+    _channelMembers.clear();
+    _memberEvents++;
+  }
+
   while (handle != 0) {
     // get server's unique identifier
     char *uid;
@@ -107,6 +168,35 @@ bool ts3_moveToChannel(uint64 channelId, std::string password) {
   return true;
 }
 
+static bool isClientMuted(anyID clientId) {
+  return (_mutedClients[clientId / 64] & ((uint64_t)1 << (clientId % 64))) != 0;
+}
+
+static void setClientMuted(anyID clientId, bool mute) {
+  if (mute) {
+    _mutedClients[clientId / 64] |= ((uint64_t)1 << (clientId % 64));
+  } else {
+    _mutedClients[clientId / 64] &= ~((uint64_t)1 << (clientId % 64));
+  }
+}
+
+static bool requestMuteClients(std::vector<anyID> &clientIds, bool mute) {
+  // terminate array with zero element
+  clientIds.push_back(0);
+
+  unsigned int result;
+
+  if (mute) {
+    result = ts3Functions.requestMuteClients(_serverConnectionHandler, clientIds.data(), NULL);
+  } else {
+    result = ts3Functions.requestUnmuteClients(_serverConnectionHandler, clientIds.data(), NULL);
+  }
+
+  clientIds.pop_back();
+
+  return result == ERROR_ok;
+}
+
 bool ts3_muteClient(anyID clientId, bool mute) {
   std::set<anyID> clients;
   clients.insert(clientId);
@@ -115,123 +205,165 @@ bool ts3_muteClient(anyID clientId, bool mute) {
 }
 
 bool ts3_muteClients(std::set<anyID> &clients, bool mute) {
-  if (clients.empty()) {
-    return true;
-  }
+  std::lock_guard<std::mutex> lock(_muteMutex);
 
-  // create client list
-  anyID *clientIds = (anyID *)malloc((clients.size() + 1) * sizeof(anyID));
+  // only request clients whose mute state changes
+  std::vector<anyID> clientIds;
+  clientIds.reserve(clients.size() + 1);
 
-  int index = 0;
   for (auto it = clients.begin(); it != clients.end(); it++) {
-    clientIds[index++] = *it;
+    if (*it != 0 && isClientMuted(*it) != mute) {
+      clientIds.push_back(*it);
+    }
   }
 
-  // terminate array with zero element
-  clientIds[index] = 0;
+  if (clientIds.empty()) {
+    return true;
+  }
 
   // apply (un-)mute on clients
-  unsigned int result;
+  if (requestMuteClients(clientIds, mute) == false) {
+    ts3_log(std::string("Unable to ") + (mute ? "mute" : "unmute") + " clients", LogLevel_DEBUG);
+    return false;
+  }
 
-  if (mute) {
-    result = ts3Functions.requestMuteClients(_serverConnectionHandler, clientIds, NULL);
-    if (result == ERROR_ok) {
-      // add all new clients to cached list
-      for (auto it = clients.begin(); it != clients.end(); it++) {
-        ts3_log("Add client to cached list " + std::to_string(*it), LogLevel_DEBUG);
-        _mutedClients.insert(*it);
-      }
-    } else {
-      ts3_log("Unable to mute clients", LogLevel_DEBUG);
-    }
-  } else {
-    result = ts3Functions.requestUnmuteClients(_serverConnectionHandler, clientIds, NULL);
-    if (result == ERROR_ok) {
-      // remove all clients from cached list
-      for (auto it = clients.begin(); it != clients.end(); it++) {
-        // client to be erased
-        anyID clientId = *it;
-        
-        auto eraseIt = _mutedClients.begin();
-        while (eraseIt != _mutedClients.end()) {
-          if (*eraseIt == clientId) {
-            ts3_log("Remove client from cached list " + std::to_string(*it), LogLevel_DEBUG);
-            eraseIt = _mutedClients.erase(eraseIt);
-          } else {
-            eraseIt++;
-          }
-        }
-      }
-    } else {
-      ts3_log("Unable to unmute clients", LogLevel_DEBUG);
-    }
+  for (auto it = clientIds.begin(); it != clientIds.end(); it++) {
+    setClientMuted(*it, mute);
   }
 
-  // cleanup list
-  free(clientIds);
+  ts3_log(std::string(mute ? "Muted " : "Unmuted ") + std::to_string(clientIds.size()) + " of " + std::to_string(clients.size()) + " clients", LogLevel_DEBUG);
 
-  return result == ERROR_ok;
+  return true;
 }
 
 bool ts3_unmuteAllClients() {
-  if (_mutedClients.empty()) {
+  std::lock_guard<std::mutex> lock(_muteMutex);
+
+  // collect all set bits of the mute table
+  std::vector<anyID> clientIds;
+
+  for (size_t i = 0; i < MUTE_TABLE_WORDS; i++) {
+    auto word = _mutedClients[i];
+
+    for (size_t bit = 0; word != 0; bit++, word >>= 1) {
+      if (word & 1) {
+        clientIds.push_back((anyID)(i * 64 + bit));
+      }
+    }
+  }
+
+  if (clientIds.empty()) {
     return true;
   }
 
-  // create client list
-  anyID *clientIds = (anyID *)malloc((_mutedClients.size() + 1) * sizeof(anyID));
+  ts3_log("Try to unmute " + std::to_string(clientIds.size()) + " clients", LogLevel_DEBUG);
 
-  int index = 0;
-  for (auto it = _mutedClients.begin(); it != _mutedClients.end(); it++) {
-    ts3_log("Try to unmute client " + std::to_string(*it), LogLevel_DEBUG);
-    clientIds[index++] = *it;
+  auto result = requestMuteClients(clientIds, false);
+
+  memset(_mutedClients, 0, sizeof(_mutedClients));
+
+  return result;
+}
+
+void ts3_forgetClient(anyID clientId) {
+  {
+    std::lock_guard<std::mutex> lock(_muteMutex);
+    setClientMuted(clientId, false);
   }
 
-  // terminate array with zero element
-  clientIds[index] = 0;
+  std::lock_guard<std::mutex> lock(_positionMutex);
+  _clientPositions.erase(clientId);
+}
 
-  // apply (un-)mute on clients
-  auto result = ts3Functions.requestUnmuteClients(_serverConnectionHandler, clientIds, NULL);
+void ts3_forgetClients(uint64 serverConnectionHandlerId) {
+  if (serverConnectionHandlerId != _serverConnectionHandler) {
+    return;
+  }
 
-  // cleanup list
-  free(clientIds);
+  // the server forgot all mutes and reuses client ids after reconnecting
+  forgetClients();
+}
 
-  _mutedClients.clear();
+static bool isChannelSubscribed(uint64 channelId, bool *subscribed) {
+  int isSubscribed;
+  if (ts3Functions.getChannelVariableAsInt(_serverConnectionHandler, channelId, CHANNEL_FLAG_ARE_SUBSCRIBED, &isSubscribed) != ERROR_ok) {
+    ts3_log("Unable to get channel's subscription state " + std::to_string(channelId), LogLevel_WARNING);
+    return false;
+  }
 
-  return result == ERROR_ok;
+  *subscribed = isSubscribed != 0;
+  return true;
 }
 
-std::set<anyID> ts3_clientsInChannel(uint64 channelId) {
-  anyID *clientList;
-  std::set<anyID> clients;
+bool ts3_subscribeChannel(uint64 channelId, uint32_t timeout) {
+  bool subscribed;
+  if (isChannelSubscribed(channelId, &subscribed) == false) {
+    return false;
+  } else if (subscribed) {
+    return true;
+  }
+
+  // remember the event count before requesting to not miss a fast answer
+  uint64_t events;
+  {
+    std::lock_guard<std::mutex> lock(_subscriptionMutex);
+    events = _subscriptionEvents;
+  }
 
-  // subscribe to channel to be able to get clients 
   uint64 channelIds[2];
   channelIds[0] = channelId;
   channelIds[1] = 0;
 
-  auto result = ts3Functions.requestChannelSubscribe(_serverConnectionHandler, channelIds, NULL);
-  if (result != ERROR_ok) {
+  if (ts3Functions.requestChannelSubscribe(_serverConnectionHandler, channelIds, NULL) != ERROR_ok) {
     ts3_log("Unable to subscribe to channel " + std::to_string(channelId), LogLevel_WARNING);
-    return clients;
+    return false;
   }
 
-  int isSubscribed;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+  while (true) {
+    // wait for the next subscription event, the flag is checked after every event
+    {
+      std::unique_lock<std::mutex> lock(_subscriptionMutex);
+      if (_subscriptionCondition.wait_until(lock, deadline, [events]() { return _subscriptionEvents != events; }) == false) {
+        break;
+      }
 
-  do {
-    ts3_log("Wait for channel subscription", LogLevel_DEBUG);
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      events = _subscriptionEvents;
+    }
 
-    if (ts3Functions.getChannelVariableAsInt(_serverConnectionHandler, channelId, CHANNEL_FLAG_ARE_SUBSCRIBED, &isSubscribed) != ERROR_ok) {
-      ts3_log("Unable to get channel's subscrition state " + std::to_string(channelId), LogLevel_WARNING);
-      return clients;
+    if (isChannelSubscribed(channelId, &subscribed) == false) {
+      return false;
+    } else if (subscribed) {
+      return true;
     }
-  } while(isSubscribed == false);
+  }
+
+  // events may arrive on the thread waiting here, check the flag a last time
+  if (isChannelSubscribed(channelId, &subscribed) && subscribed) {
+    return true;
+  }
 
-  result = ts3Functions.getChannelClientList(_serverConnectionHandler, channelId, &clientList);
+  ts3_log("Timed out subscribing to channel " + std::to_string(channelId), LogLevel_WARNING);
+  return false;
+}
+
+void ts3_channelSubscriptionChanged() {
+  {
+    std::lock_guard<std::mutex> lock(_subscriptionMutex);
+    _subscriptionEvents++;
+  }
+
+  _subscriptionCondition.notify_all();
+}
+
+static bool requestChannelClients(uint64 channelId, std::set<anyID> *clients) {
+  anyID *clientList;
+
+  auto result = ts3Functions.getChannelClientList(_serverConnectionHandler, channelId, &clientList);
   if (result != ERROR_ok) {
     ts3_log("Unable to get clients for channel " + std::to_string(channelId), LogLevel_WARNING);
-    return clients;
+    return false;
   }
 
   // put client ids into the set
@@ -239,16 +371,85 @@ std::set<anyID> ts3_clientsInChannel(uint64 channelId) {
   anyID id = clientList[index];
 
   while (id != 0) {
-    clients.insert(id);
+    clients->insert(id);
 
     index++;
     id = clientList[index];
   }
 
   ts3Functions.freeMemory(clientList);
+  return true;
+}
+
+std::set<anyID> ts3_clientsInChannel(uint64 channelId) {
+  std::set<anyID> clients;
+
+  // channels are only fetched once, moves keep the index up to date afterwards
+  uint64_t events;
+  {
+    std::lock_guard<std::mutex> lock(_memberMutex);
+
+    auto it = _channelMembers.find(channelId);
+    if (it != _channelMembers.end()) {
+      return (*it).second;
+    }
+
+    events = _memberEvents;
+  }
+
+  // subscribe to channel to be able to get clients
+  if (ts3_subscribeChannel(channelId, TEAMSPEAK_SUBSCRIBE_TIMEOUT) == false) {
+    return clients;
+  }
+
+  if (requestChannelClients(channelId, &clients) == false) {
+    return clients;
+  }
+
+  // moves reported while fetching might be missing in the list, seed on the next call
+  std::lock_guard<std::mutex> lock(_memberMutex);
+  if (_memberEvents == events) {
+    _channelMembers[channelId] = clients;
+  }
+
   return clients;
 }
 
+void ts3_channelMemberMoved(uint64 serverConnectionHandlerId, anyID clientId, uint64 oldChannelId, uint64 newChannelId) {
+  if (serverConnectionHandlerId != _serverConnectionHandler) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(_memberMutex);
+  _memberEvents++;
+
+  auto it = _channelMembers.find(oldChannelId);
+  if (it != _channelMembers.end()) {
+    (*it).second.erase(clientId);
+  }
+
+  it = _channelMembers.find(newChannelId);
+  if (it != _channelMembers.end()) {
+    (*it).second.insert(clientId);
+  }
+}
+
+void ts3_forgetChannelMembers(uint64 serverConnectionHandlerId, uint64 channelId) {
+  if (serverConnectionHandlerId != _serverConnectionHandler) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(_memberMutex);
+  _memberEvents++;
+
+  // zero drops all channels
+  if (channelId == 0) {
+    _channelMembers.clear();
+  } else {
+    _channelMembers.erase(channelId);
+  }
+}
+
 bool ts3_setNickname(std::string nickname) {
   if (_serverConnectionHandler == 0) {
     return false;
@@ -323,23 +524,75 @@ std::string ts3_getClientIdentity() {
 }
 
 bool ts3_setClientPosition(anyID clientId, float x, float y, float z) {
+  std::vector<ts3ClientPosition_t> positions(1);
+  positions[0].clientId = clientId;
+  positions[0].x = x;
+  positions[0].y = y;
+  positions[0].z = z;
+
+  return ts3_setClientPositions(positions);
+}
+
+bool ts3_setClientPositions(const std::vector<ts3ClientPosition_t> &positions) {
   if (_serverConnectionHandler == 0) {
     return false;
   }
 
-  TS3_VECTOR position;
-  position.x = x;
-  position.y = y;
-  position.z = z;
+  std::lock_guard<std::mutex> lock(_positionMutex);
 
-  if (ts3Functions.channelset3DAttributes(_serverConnectionHandler, clientId, &position) != ERROR_ok) {
-    ts3_log("Unable to set position for client " + std::to_string(clientId), LogLevel_WARNING);
+  float epsilon = _positionEpsilon;
+  uint64_t applied = 0;
+  uint64_t skipped = 0;
+  int failed = 0;
+
+  for (auto it = positions.begin(); it != positions.end(); it++) {
+    // skip clients which did not move further than the epsilon since the last applied position
+    auto cached = _clientPositions.find((*it).clientId);
+    if (cached != _clientPositions.end()) {
+      float dx = (*it).x - (*cached).second.x;
+      float dy = (*it).y - (*cached).second.y;
+      float dz = (*it).z - (*cached).second.z;
+
+      if (dx * dx + dy * dy + dz * dz <= epsilon * epsilon) {
+        skipped++;
+        continue;
+      }
+    }
+
+    TS3_VECTOR position;
+    position.x = (*it).x;
+    position.y = (*it).y;
+    position.z = (*it).z;
+
+    if (ts3Functions.channelset3DAttributes(_serverConnectionHandler, (*it).clientId, &position) != ERROR_ok) {
+      failed++;
+      continue;
+    }
+
+    _clientPositions[(*it).clientId] = position;
+    applied++;
+  }
+
+  _appliedPositions += applied;
+  _skippedPositions += skipped;
+
+  if (failed > 0) {
+    ts3_log("Unable to set position for " + std::to_string(failed) + " clients", LogLevel_WARNING);
     return false;
   }
 
   return true;
 }
 
+void ts3_setPositionEpsilon(float epsilon) {
+  _positionEpsilon = epsilon;
+}
+
+void ts3_positionCounters(uint64_t *applied, uint64_t *skipped) {
+  *applied = _appliedPositions;
+  *skipped = _skippedPositions;
+}
+
 bool ts3_resetListenerPosition() {
   if (_serverConnectionHandler == 0) {
     return false;
@@ -389,22 +642,27 @@ void ts3_resetClients3DPositions() {
   auto channelId = ts3_channelId(_serverConnectionHandler);
   auto clients = ts3_clientsInChannel(channelId);
 
+  std::vector<ts3ClientPosition_t> positions;
+  positions.reserve(clients.size());
+
   for (auto it = clients.begin(); it != clients.end(); it++) {
-    ts3_setClientPosition(*it, 0, 0, 0);
+    ts3ClientPosition_t position;
+    position.clientId = *it;
+    position.x = 0;
+    position.y = 0;
+    position.z = 0;
+
+    positions.push_back(position);
   }
+
+  ts3_setClientPositions(positions);
 }
 
 uint64 ts3_serverConnectionHandle() {
   return _serverConnectionHandler;
 }
 
-anyID ts3_clientId(uint64 serverConnectionHandlerId) {
-  // check if connected to the server
-  if (serverConnectionHandlerId == 0) {
-    ts3_log("Unable to get client ID when not connected to a server", LogLevel_WARNING);
-    return 0;
-  }
-
+static anyID requestClientId(uint64 serverConnectionHandlerId) {
   int status;
   int result = ts3Functions.getConnectionStatus(serverConnectionHandlerId, &status);
   if (result != ERROR_ok) {
@@ -429,9 +687,57 @@ anyID ts3_clientId(uint64 serverConnectionHandlerId) {
   return clientID;
 }
 
+anyID ts3_clientId(uint64 serverConnectionHandlerId) {
+  // check if connected to the server
+  if (serverConnectionHandlerId == 0) {
+    ts3_log("Unable to get client ID when not connected to a server", LogLevel_WARNING);
+    return 0;
+  }
+
+  uint64_t events;
+  {
+    std::lock_guard<std::mutex> lock(_ownClientMutex);
+
+    auto it = _ownClients.find(serverConnectionHandlerId);
+    if (it != _ownClients.end() && (*it).second.clientId != 0) {
+      return (*it).second.clientId;
+    }
+
+    events = _ownClientEvents;
+  }
+
+  auto clientId = requestClientId(serverConnectionHandlerId);
+  if (clientId == 0) {
+    return 0;
+  }
+
+  // an id requested before a connection change must not be cached for the new one
+  std::lock_guard<std::mutex> lock(_ownClientMutex);
+  if (_ownClientEvents == events) {
+    _ownClients[serverConnectionHandlerId].clientId = clientId;
+  }
+
+  return clientId;
+}
+
 uint64 ts3_channelId(uint64 serverConnectionHandlerId) {
+  uint64_t events;
+  {
+    std::lock_guard<std::mutex> lock(_ownClientMutex);
+
+    auto it = _ownClients.find(serverConnectionHandlerId);
+    if (it != _ownClients.end() && (*it).second.channelId != 0) {
+      return (*it).second.channelId;
+    }
+
+    events = _ownClientEvents;
+  }
+
   uint64 channelId;
   auto clientId = ts3_clientId(serverConnectionHandlerId);
+  if (clientId == 0) {
+    return 0;
+  }
 
   auto result = ts3Functions.getChannelOfClient(serverConnectionHandlerId, clientId, &channelId);
   if (result != ERROR_ok) {
@@ -439,9 +745,41 @@ uint64 ts3_channelId(uint64 serverConnectionHandlerId) {
     return 0;
   }
 
+  // a move reported while requesting is newer than the requested channel
+  std::lock_guard<std::mutex> lock(_ownClientMutex);
+  if (_ownClientEvents != events) {
+    auto it = _ownClients.find(serverConnectionHandlerId);
+    if (it != _ownClients.end() && (*it).second.channelId != 0) {
+      return (*it).second.channelId;
+    }
+
+    return channelId;
+  }
+
+  _ownClients[serverConnectionHandlerId].channelId = channelId;
+
   return channelId;
 }
 
+void ts3_ownChannelChanged(uint64 serverConnectionHandlerId, uint64 channelId) {
+  std::lock_guard<std::mutex> lock(_ownClientMutex);
+  _ownClientEvents++;
+
+  // leaving the server is followed by a connect status change
+  if (channelId == 0) {
+    _ownClients.erase(serverConnectionHandlerId);
+    return;
+  }
+
+  _ownClients[serverConnectionHandlerId].channelId = channelId;
+}
+
+void ts3_invalidateOwnClient(uint64 serverConnectionHandlerId) {
+  std::lock_guard<std::mutex> lock(_ownClientMutex);
+  _ownClientEvents++;
+  _ownClients.erase(serverConnectionHandlerId);
+}
+
 bool ts3_isInputMuted(uint64 serverConnectionHandlerId) {
   int hardwareStatus;
   int deactivated;
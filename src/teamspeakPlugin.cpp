@@ -77,6 +77,13 @@ void ts3plugin_shutdown() {
   JustAnotherVoiceChat_stop();
 }
 
+void ts3plugin_onConnectStatusChangeEvent(uint64 serverConnectionHandlerID, int, unsigned int) {
+  // client id, channel, members, mutes and positions are only valid for a single connection
+  ts3_invalidateOwnClient(serverConnectionHandlerID);
+  ts3_forgetChannelMembers(serverConnectionHandlerID, 0);
+  ts3_forgetClients(serverConnectionHandlerID);
+}
+
 void ts3plugin_onTalkStatusChangeEvent(uint64 serverConnectionHandlerID, int status, int, anyID clientID) {
   if (serverConnectionHandlerID != ts3_serverConnectionHandle()) {
     return;
@@ -110,23 +117,42 @@ void ts3plugin_onClientSelfVariableUpdateEvent(uint64 serverConnectionHandlerID,
   }
 }
 
-void ts3plugin_onClientMoveEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int, const char*) {
+static void clientMoved(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID) {
+  ts3_channelMemberMoved(serverConnectionHandlerID, clientID, oldChannelID, newChannelID);
+
+  if (clientID == ts3_clientId(serverConnectionHandlerID)) {
+    ts3_ownChannelChanged(serverConnectionHandlerID, newChannelID);
+  }
+
   if (serverConnectionHandlerID != ts3_serverConnectionHandle()) {
     return;
   }
 
-  // skip the check for myself
+  // own moves complete joining the in-game channel
   if (clientID == ts3_clientId(serverConnectionHandlerID)) {
+    JustAnotherVoiceChat_ownClientMoved(newChannelID);
     return;
   }
 
+  // ids of clients leaving the server get reused, forget their mute state and position
+  if (newChannelID == 0) {
+    JustAnotherVoiceChat_forgetClient(clientID);
+    ts3_forgetClient(clientID);
+  }
+
   // only mute if ingame
   if (JustAnotherVoiceChat_isIngame() == false) {
     return;
   }
 
-  // check if client moved into my channel
+  // the updater applies server mutes and positions later, drop everything
+  // pending for the client so that nothing lands after the calls below
   auto ownChannel = ts3_channelId(serverConnectionHandlerID);
+  if (ownChannel == newChannelID || ownChannel == oldChannelID) {
+    JustAnotherVoiceChat_forgetClient(clientID);
+  }
+
+  // check if client moved into my channel
   if (ownChannel == newChannelID) {
     ts3_muteClient(clientID, true);
     return;
@@ -139,3 +165,53 @@ void ts3plugin_onClientMoveEvent(uint64 serverConnectionHandlerID, anyID clientI
     return;
   }
 }
+
+void ts3plugin_onClientMoveEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int, const char*) {
+  clientMoved(serverConnectionHandlerID, clientID, oldChannelID, newChannelID);
+}
+
+void ts3plugin_onClientMoveTimeoutEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int, const char*) {
+  clientMoved(serverConnectionHandlerID, clientID, oldChannelID, newChannelID);
+}
+
+void ts3plugin_onClientMoveMovedEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int, anyID, const char*, const char*, const char*) {
+  clientMoved(serverConnectionHandlerID, clientID, oldChannelID, newChannelID);
+}
+
+void ts3plugin_onClientKickFromChannelEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int, anyID, const char*, const char*, const char*) {
+  clientMoved(serverConnectionHandlerID, clientID, oldChannelID, newChannelID);
+}
+
+void ts3plugin_onClientKickFromServerEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int, anyID, const char*, const char*, const char*) {
+  clientMoved(serverConnectionHandlerID, clientID, oldChannelID, newChannelID);
+}
+
+void ts3plugin_onClientMoveSubscriptionEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int) {
+  // clients becoming visible by subscribing did not actually move
+  ts3_channelMemberMoved(serverConnectionHandlerID, clientID, oldChannelID, newChannelID);
+}
+
+void ts3plugin_onChannelUnsubscribeEvent(uint64 serverConnectionHandlerID, uint64 channelID) {
+  // moves in unsubscribed channels are not reported anymore
+  ts3_forgetChannelMembers(serverConnectionHandlerID, channelID);
+}
+
+void ts3plugin_onDelChannelEvent(uint64 serverConnectionHandlerID, uint64 channelID, anyID, const char*, const char*) {
+  ts3_forgetChannelMembers(serverConnectionHandlerID, channelID);
+}
+
+void ts3plugin_onChannelSubscribeEvent(uint64 serverConnectionHandlerID, uint64) {
+  if (serverConnectionHandlerID != ts3_serverConnectionHandle()) {
+    return;
+  }
+
+  ts3_channelSubscriptionChanged();
+}
+
+void ts3plugin_onChannelSubscribeFinishedEvent(uint64 serverConnectionHandlerID) {
+  if (serverConnectionHandlerID != ts3_serverConnectionHandle()) {
+    return;
+  }
+
+  ts3_channelSubscriptionChanged();
+}
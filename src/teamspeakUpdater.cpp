@@ -0,0 +1,298 @@
+/*
+ * File: src/teamspeakUpdater.cpp
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "teamspeakUpdater.h"
+
+#include <chrono>
+#include <algorithm>
+
+#include "teamspeak.h"
+
+TeamspeakUpdater::TeamspeakUpdater() {
+  _thread = nullptr;
+  _running = false;
+  _interval = TEAMSPEAK_UPDATE_INTERVAL;
+  _hasPendingNickname = false;
+  _forgetGeneration = 0;
+}
+
+TeamspeakUpdater::~TeamspeakUpdater() {
+  stop();
+}
+
+void TeamspeakUpdater::start(uint32_t interval) {
+  if (_thread != nullptr) {
+    return;
+  }
+
+  _interval = interval;
+  _running = true;
+  _thread = new std::thread(&TeamspeakUpdater::update, this);
+}
+
+void TeamspeakUpdater::stop() {
+  if (_thread == nullptr) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_pendingMutex);
+    _running = false;
+  }
+
+  _pendingCondition.notify_all();
+
+  if (_thread->joinable()) {
+    _thread->join();
+  }
+
+  delete _thread;
+  _thread = nullptr;
+}
+
+void TeamspeakUpdater::setMuted(anyID clientId, bool muted) {
+  {
+    std::lock_guard<std::mutex> lock(_pendingMutex);
+    _pendingMutes[clientId] = muted;
+  }
+
+  _pendingCondition.notify_one();
+}
+
+void TeamspeakUpdater::setPosition(anyID clientId, float x, float y, float z) {
+  // samples are timed on arrival, the voice server sends no timestamps
+  positionSample_t sample;
+  sample.position.x = x;
+  sample.position.y = y;
+  sample.position.z = z;
+  sample.time = std::chrono::steady_clock::now();
+
+  {
+    std::lock_guard<std::mutex> lock(_pendingMutex);
+    _pendingPositions[clientId] = sample;
+  }
+
+  _pendingCondition.notify_one();
+}
+
+void TeamspeakUpdater::setPositions(const std::vector<ts3ClientPosition_t> &positions) {
+  if (positions.empty()) {
+    return;
+  }
+
+  // all positions of a frame arrive at the same time
+  positionSample_t sample;
+  sample.time = std::chrono::steady_clock::now();
+
+  {
+    std::lock_guard<std::mutex> lock(_pendingMutex);
+
+    for (auto it = positions.begin(); it != positions.end(); it++) {
+      sample.position.x = (*it).x;
+      sample.position.y = (*it).y;
+      sample.position.z = (*it).z;
+
+      _pendingPositions[(*it).clientId] = sample;
+    }
+  }
+
+  _pendingCondition.notify_one();
+}
+
+void TeamspeakUpdater::setNickname(std::string nickname) {
+  {
+    std::lock_guard<std::mutex> lock(_pendingMutex);
+    _pendingNickname = nickname;
+    _hasPendingNickname = true;
+  }
+
+  _pendingCondition.notify_one();
+}
+
+void TeamspeakUpdater::forget(anyID clientId) {
+  // called from teamspeak events, never wait for updates being applied. A run
+  // in progress skips the client and the next one drops its motion, so a
+  // reused id starts without motion
+  std::lock_guard<std::mutex> lock(_pendingMutex);
+
+  _pendingMutes.erase(clientId);
+  _pendingPositions.erase(clientId);
+
+  _forgottenClients.insert(clientId);
+  _forgetGeneration++;
+}
+
+void TeamspeakUpdater::clear() {
+  // wait for updates being applied right now, nothing reaches teamspeak afterwards
+  std::lock_guard<std::mutex> applyLock(_applyMutex);
+  std::lock_guard<std::mutex> lock(_pendingMutex);
+
+  _pendingMutes.clear();
+  _pendingPositions.clear();
+  _pendingNickname = "";
+  _hasPendingNickname = false;
+  _forgottenClients.clear();
+
+  _motions.clear();
+}
+
+void TeamspeakUpdater::update() {
+  bool moving = false;
+
+  while (_running) {
+    // sleep until updates arrive unless clients are still moving
+    if (moving == false) {
+      std::unique_lock<std::mutex> lock(_pendingMutex);
+      _pendingCondition.wait(lock, [this]() {
+        return _running == false || hasPendingUpdates();
+      });
+    }
+
+    if (_running == false) {
+      break;
+    }
+
+    moving = apply();
+
+    // bound the rate of teamspeak calls, updates arriving meanwhile are merged
+    std::unique_lock<std::mutex> lock(_pendingMutex);
+    _pendingCondition.wait_for(lock, std::chrono::milliseconds(_interval), [this]() {
+      return _running == false;
+    });
+  }
+}
+
+bool TeamspeakUpdater::apply() {
+  std::lock_guard<std::mutex> applyLock(_applyMutex);
+
+  std::unordered_map<anyID, bool> mutes;
+  std::unordered_map<anyID, positionSample_t> positions;
+  std::string nickname;
+  bool hasNickname;
+  std::set<anyID> forgotten;
+  uint64_t generation;
+
+  // take all pending updates at once, the network thread never waits for teamspeak
+  {
+    std::lock_guard<std::mutex> lock(_pendingMutex);
+    mutes.swap(_pendingMutes);
+    positions.swap(_pendingPositions);
+    nickname.swap(_pendingNickname);
+    hasNickname = _hasPendingNickname;
+    _hasPendingNickname = false;
+    forgotten.swap(_forgottenClients);
+    generation = _forgetGeneration;
+  }
+
+  for (auto it = forgotten.begin(); it != forgotten.end(); it++) {
+    _motions.erase(*it);
+  }
+
+  std::set<anyID> muteClients;
+  std::set<anyID> unmuteClients;
+
+  for (auto it = mutes.begin(); it != mutes.end(); it++) {
+    if ((*it).second) {
+      ts3_log("Mute teamspeak user " + std::to_string((*it).first), LogLevel_DEBUG);
+
+      muteClients.insert((*it).first);
+    } else {
+      ts3_log("Unmute teamspeak user " + std::to_string((*it).first), LogLevel_DEBUG);
+
+      unmuteClients.insert((*it).first);
+    }
+  }
+
+  // clients forgotten meanwhile are muted or unmuted directly by the plugin
+  forgotten = forgottenSince(generation);
+  for (auto it = forgotten.begin(); it != forgotten.end(); it++) {
+    muteClients.erase(*it);
+    unmuteClients.erase(*it);
+  }
+
+  ts3_muteClients(muteClients, true);
+  ts3_muteClients(unmuteClients, false);
+
+  if (hasNickname && nickname.compare("") != 0) {
+    ts3_setNickname(nickname);
+  }
+
+  // render positions of all clients for this frame
+  for (auto it = positions.begin(); it != positions.end(); it++) {
+    _motions[(*it).first].addSample((*it).second.time, (*it).second.position);
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  bool moving = false;
+
+  std::vector<ts3ClientPosition_t> rendered;
+  rendered.reserve(_motions.size());
+
+  for (auto it = _motions.begin(); it != _motions.end(); it++) {
+    clientPosition_t position;
+    if ((*it).second.render(now, &position)) {
+      ts3ClientPosition_t update;
+      update.clientId = (*it).first;
+      update.x = position.x;
+      update.y = position.y;
+      update.z = position.z;
+
+      rendered.push_back(update);
+    }
+
+    moving = moving || (*it).second.isSettled(now) == false;
+  }
+
+  // positions of clients forgotten meanwhile were reset by the plugin
+  forgotten = forgottenSince(generation);
+  if (forgotten.empty() == false) {
+    rendered.erase(std::remove_if(rendered.begin(), rendered.end(), [&forgotten](const ts3ClientPosition_t &update) {
+      return forgotten.count(update.clientId) > 0;
+    }), rendered.end());
+  }
+
+  // positions closer than the epsilon to the applied ones are skipped
+  if (rendered.empty() == false) {
+    ts3_setClientPositions(rendered);
+  }
+
+  return moving;
+}
+
+bool TeamspeakUpdater::hasPendingUpdates() const {
+  return _pendingMutes.empty() == false || _pendingPositions.empty() == false || _hasPendingNickname;
+}
+
+std::set<anyID> TeamspeakUpdater::forgottenSince(uint64_t generation) {
+  std::lock_guard<std::mutex> lock(_pendingMutex);
+
+  if (_forgetGeneration == generation) {
+    return std::set<anyID>();
+  }
+
+  return _forgottenClients;
+}
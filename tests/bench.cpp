@@ -0,0 +1,479 @@
+/*
+ * File: tests/bench.cpp
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <stdlib.h>
+#include <new>
+
+#include <cereal/archives/binary.hpp>
+
+#include "protocol.h"
+#include "networkWakeup.h"
+#include "client.h"
+#include "config.h"
+#include "clientHarness.h"
+
+// Serialization benchmark printing one CSV line per packet type, wire format,
+// entry count and operation to compare encoding and decoding costs.
+
+#define BENCH_OPERATIONS_PER_RUN 2000000
+#define BENCH_MIN_ITERATIONS 100
+#define BENCH_LATENCY_SAMPLES 50
+#define BENCH_LATENCY_SPACING 60
+#define BENCH_JOIN_TIMEOUT 5000
+
+// counted from the bench and the ENet threads alike
+static std::atomic<size_t> allocations(0);
+
+void *operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+
+  void *pointer = malloc(size > 0 ? size : 1);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  return pointer;
+}
+
+void operator delete(void *pointer) noexcept {
+  free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+  free(pointer);
+}
+
+// ENet allocates packets with its own callbacks, count those as well
+static void *countingMalloc(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return malloc(size);
+}
+
+static void countingFree(void *pointer) {
+  free(pointer);
+}
+
+static void noMemory() {
+  abort();
+}
+
+typedef struct {
+  size_t bytes;
+  double nanoseconds;
+  double allocations;
+} benchResult_t;
+
+static void printResult(const std::string &packet, const std::string &format, size_t entries, const std::string &operation, benchResult_t &result) {
+  std::cout << packet << "," << format << "," << entries << "," << operation << "," << (uint64_t)result.nanoseconds << "," << result.bytes << "," << result.allocations << std::endl;
+}
+
+static size_t iterationsFor(size_t entries) {
+  size_t iterations = BENCH_OPERATIONS_PER_RUN / (entries + 1);
+  return iterations < BENCH_MIN_ITERATIONS ? BENCH_MIN_ITERATIONS : iterations;
+}
+
+template <class Function>
+static benchResult_t measure(size_t iterations, size_t bytes, Function function) {
+  // warm up caches and allocator
+  function();
+
+  size_t allocationsBefore = allocations.load(std::memory_order_relaxed);
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < iterations; i++) {
+    function();
+  }
+
+  auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+  benchResult_t result;
+  result.bytes = bytes;
+  result.nanoseconds = (double)duration.count() / iterations;
+  result.allocations = (double)(allocations.load(std::memory_order_relaxed) - allocationsBefore) / iterations;
+
+  return result;
+}
+
+// cereal binary archives on top of std streams, the format used before the packet archives
+template <class T>
+static std::string encodeWithStream(T &packet) {
+  std::ostringstream os;
+
+  cereal::BinaryOutputArchive archive(os);
+  archive(packet);
+
+  return os.str();
+}
+
+template <class T>
+static T decodeWithStream(const std::string &data) {
+  std::istringstream is(data);
+
+  T outputPacket;
+
+  cereal::BinaryInputArchive archive(is);
+  archive(outputPacket);
+
+  return outputPacket;
+}
+
+template <class T>
+static void benchPacket(const std::string &name, const std::string &format, size_t entries, T &packet, bool withStream) {
+  bool result = false;
+  auto reference = serializePacket<T>(packet, &result);
+  if (result == false) {
+    std::cerr << "Unable to serialize " << name << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  size_t bytes = reference->dataLength;
+  size_t iterations = iterationsFor(entries);
+
+  deserializePacket<T>(reference, &result);
+  if (result == false) {
+    std::cerr << "Unable to deserialize " << name << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  auto encodeResult = measure(iterations, bytes, [&packet]() {
+    auto data = serializePacket<T>(packet, nullptr);
+    enet_packet_destroy(data);
+  });
+
+  auto decodeResult = measure(iterations, bytes, [reference]() {
+    auto outputPacket = deserializePacket<T>(reference, nullptr);
+    (void)outputPacket;
+  });
+
+  printResult(name, format, entries, "encode", encodeResult);
+  printResult(name, format, entries, "decode", decodeResult);
+
+  if (withStream) {
+    auto data = encodeWithStream<T>(packet);
+
+    auto streamEncodeResult = measure(iterations, data.size(), [&packet]() {
+      auto data = encodeWithStream<T>(packet);
+      (void)data;
+    });
+
+    auto streamDecodeResult = measure(iterations, data.size(), [&data]() {
+      auto outputPacket = decodeWithStream<T>(data);
+      (void)outputPacket;
+    });
+
+    printResult(name, format + "-stream", entries, "encode", streamEncodeResult);
+    printResult(name, format + "-stream", entries, "decode", streamDecodeResult);
+  }
+
+  enet_packet_destroy(reference);
+}
+
+static clientPositionUpdate_t makePosition(uint16_t teamspeakId) {
+  clientPositionUpdate_t position;
+  position.teamspeakId = teamspeakId;
+  position.x = 100.0f + (teamspeakId % 100) * 1.5f;
+  position.y = 200.0f - (teamspeakId % 50) * 2.25f;
+  position.z = 10.0f + (teamspeakId % 7) * 0.5f;
+  position.voiceRange = 25.0f;
+
+  return position;
+}
+
+static positionPacket_t makePositionPacket(size_t entries) {
+  positionPacket_t packet;
+  packet.x = 100.0f;
+  packet.y = 200.0f;
+  packet.z = 10.0f;
+  packet.rotation = 1.0f;
+
+  for (size_t i = 1; i <= entries; i++) {
+    packet.positions.push_back(makePosition((uint16_t)i));
+  }
+
+  return packet;
+}
+
+static positionFramePacket_t makePositionFrame(size_t entries, uint8_t encoding) {
+  positionFramePacket_t packet;
+  packet.frameType = POSITION_FRAME_KEYFRAME;
+  packet.encoding = encoding;
+  packet.keyframe = 1;
+  packet.scale = 0.01f;
+  packet.x = 100.0f;
+  packet.y = 200.0f;
+  packet.z = 10.0f;
+  packet.rotation = 1.0f;
+
+  for (size_t i = 1; i <= entries; i++) {
+    auto position = makePosition((uint16_t)i);
+
+    packet.teamspeakIds.push_back(position.teamspeakId);
+    packet.positionsX.push_back(position.x);
+    packet.positionsY.push_back(position.y);
+    packet.positionsZ.push_back(position.z);
+    packet.voiceRanges.push_back(position.voiceRange);
+  }
+
+  return packet;
+}
+
+static updatePacket_t makeUpdatePacket(size_t entries) {
+  updatePacket_t packet;
+
+  for (size_t i = 1; i <= entries; i++) {
+    clientAudioUpdate_t audioUpdate;
+    audioUpdate.teamspeakId = (uint16_t)i;
+    audioUpdate.muted = (i % 2) == 0;
+    audioUpdate.volume = 1.0f;
+
+    packet.audioUpdates.push_back(audioUpdate);
+    packet.positionUpdates.push_back(makePosition((uint16_t)i));
+  }
+
+  return packet;
+}
+
+// handshake responses carry no lists, entries scale the length of the strings instead
+static handshakeResponsePacket_t makeHandshakeResponsePacket(size_t entries) {
+  if (entries > PACKET_MAX_STRING_LENGTH) {
+    entries = PACKET_MAX_STRING_LENGTH;
+  }
+
+  handshakeResponsePacket_t packet;
+  packet.statusCode = STATUS_CODE_OK;
+  packet.reason = std::string(entries, 'r');
+  packet.teamspeakServerUniqueIdentifier = "hOKGlOtB0Bgs6Wnqh2TkQ2Gy+dA=";
+  packet.channelId = 1234;
+  packet.channelPassword = std::string(entries, 'p');
+  packet.resumptionToken = std::string(32, 't');
+  packet.resumed = false;
+
+  return packet;
+}
+
+// Time from queueing a status message on another thread until the server
+// received it over loopback, with the network thread servicing ENet for up to
+// 100 ms at a time as the client did before the wakeup socket. The client no
+// longer has this loop, it is rebuilt here as the reference to compare with.
+static void benchStatusLatencyPolling() {
+  ENetAddress address;
+  address.port = 0;
+  enet_address_set_host(&address, "127.0.0.1");
+
+  auto server = enet_host_create(&address, 1, NETWORK_CHANNELS, 0, 0);
+  auto client = enet_host_create(NULL, 1, NETWORK_CHANNELS, 0, 0);
+  if (server == NULL || client == NULL || enet_socket_get_address(server->socket, &address) != 0) {
+    std::cerr << "Unable to create loopback hosts" << std::endl;
+    abort();
+  }
+
+  auto peer = enet_host_connect(client, &address, NETWORK_CHANNELS, 0);
+
+  ENetEvent event;
+  bool connected = false;
+  for (int i = 0; i < 500 && connected == false; i++) {
+    enet_host_service(server, &event, 1);
+    connected = enet_host_service(client, &event, 1) > 0 && event.type == ENET_EVENT_TYPE_CONNECT;
+  }
+
+  if (connected == false) {
+    std::cerr << "Unable to connect loopback hosts" << std::endl;
+    abort();
+  }
+
+  std::mutex pendingMutex;
+  std::vector<ENetPacket *> pending;
+  std::atomic<bool> running(true);
+
+  // network thread of the client
+  std::thread networkThread([&]() {
+    ENetEvent clientEvent;
+
+    while (running) {
+      enet_host_service(client, &clientEvent, NETWORK_SERVICE_TIMEOUT);
+
+      std::lock_guard<std::mutex> lock(pendingMutex);
+      for (auto it = pending.begin(); it != pending.end(); it++) {
+        enet_peer_send(peer, NETWORK_STATUS_CHANNEL, *it);
+      }
+
+      pending.clear();
+      enet_host_flush(client);
+    }
+  });
+
+  statusPacket_t statusPacket;
+  statusPacket.talking = true;
+  statusPacket.microphoneMuted = false;
+  statusPacket.speakersMuted = false;
+
+  double totalNanoseconds = 0;
+  size_t bytes = 0;
+
+  for (size_t i = 0; i < BENCH_LATENCY_SAMPLES; i++) {
+    // vary the phase relative to the service timeout of the network thread
+    std::this_thread::sleep_for(std::chrono::milliseconds(BENCH_LATENCY_SPACING + (i * 37) % 100));
+
+    bool result = false;
+    auto packet = serializePacket<statusPacket_t>(statusPacket, &result);
+    bytes = packet->dataLength;
+
+    auto start = std::chrono::steady_clock::now();
+
+    {
+      std::lock_guard<std::mutex> lock(pendingMutex);
+      pending.push_back(packet);
+    }
+
+    bool received = false;
+    while (received == false) {
+      if (enet_host_service(server, &event, 1) > 0 && event.type == ENET_EVENT_TYPE_RECEIVE) {
+        enet_packet_destroy(event.packet);
+        received = true;
+      }
+    }
+
+    totalNanoseconds += (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  running = false;
+  networkThread.join();
+
+  enet_host_destroy(client);
+  enet_host_destroy(server);
+
+  benchResult_t result;
+  result.bytes = bytes;
+  result.nanoseconds = totalNanoseconds / BENCH_LATENCY_SAMPLES;
+  result.allocations = 0;
+
+  printResult("status", "poll", 1, "latency", result);
+}
+
+// Time from Client::setTalking until a loopback voice server received the
+// status message, going through the command queue, the wakeup socket and the
+// service loop of the real network thread.
+static void benchStatusLatencyClient() {
+  LoopbackServer server;
+  if (server.open() == false) {
+    std::cerr << "Unable to open loopback server" << std::endl;
+    abort();
+  }
+
+  auto client = new Client(config_defaults());
+  client->connect("127.0.0.1", server.port(), 1);
+
+  if (client->waitForState(CLIENT_STATE_INGAME, BENCH_JOIN_TIMEOUT) == false) {
+    std::cerr << "Client did not join the loopback server" << std::endl;
+    abort();
+  }
+
+  // the join reports the initial status
+  server.waitForStatus(1, BENCH_JOIN_TIMEOUT, nullptr);
+  auto received = server.statusMessages();
+
+  double totalNanoseconds = 0;
+  bool talking = false;
+
+  for (size_t i = 0; i < BENCH_LATENCY_SAMPLES; i++) {
+    // stay above the status rate limit, the phase varies as above
+    std::this_thread::sleep_for(std::chrono::milliseconds(BENCH_LATENCY_SPACING + (i * 37) % 100));
+
+    talking = !talking;
+
+    auto start = std::chrono::steady_clock::now();
+    client->setTalking(talking);
+
+    std::chrono::steady_clock::time_point receiveTime;
+    if (server.waitForStatus(++received, BENCH_JOIN_TIMEOUT, &receiveTime) == false) {
+      std::cerr << "Status message did not arrive" << std::endl;
+      abort();
+    }
+
+    totalNanoseconds += (double)std::chrono::duration_cast<std::chrono::nanoseconds>(receiveTime - start).count();
+  }
+
+  delete client;
+  server.close();
+
+  benchResult_t result;
+  result.bytes = 0;
+  result.nanoseconds = totalNanoseconds / BENCH_LATENCY_SAMPLES;
+  result.allocations = 0;
+
+  printResult("status", "client", 1, "latency", result);
+}
+
+int main(int, char **) {
+  ENetCallbacks callbacks;
+  callbacks.malloc = countingMalloc;
+  callbacks.free = countingFree;
+  callbacks.no_memory = noMemory;
+
+  if (enet_initialize_with_callbacks(ENET_VERSION, &callbacks) != 0) {
+    std::cerr << "Unable to initialize ENet" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "packet,format,entries,operation,ns_per_op,bytes_per_op,allocations_per_op" << std::endl;
+
+  const size_t entryCounts[] = { 1, 10, 50, 100, 500, 1000 };
+
+  for (auto entries : entryCounts) {
+    auto positionPacket = makePositionPacket(entries);
+    benchPacket<positionPacket_t>("position", "cereal", entries, positionPacket, true);
+
+    auto framePacket = makePositionFrame(entries, POSITION_ENCODING_FLOAT);
+    benchPacket<positionFramePacket_t>("position", "frame", entries, framePacket, false);
+
+    auto quantizedPacket = makePositionFrame(entries, POSITION_ENCODING_QUANTIZED);
+    benchPacket<positionFramePacket_t>("position", "frame-quantized", entries, quantizedPacket, false);
+
+    auto updatePacket = makeUpdatePacket(entries);
+    benchPacket<updatePacket_t>("update", "cereal", entries, updatePacket, true);
+
+    auto handshakePacket = makeHandshakeResponsePacket(entries);
+    benchPacket<handshakeResponsePacket_t>("handshake-response", "cereal", entries, handshakePacket, true);
+  }
+
+  harness_initTeamspeak(false);
+
+  benchStatusLatencyPolling();
+  benchStatusLatencyClient();
+
+  enet_deinitialize();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,383 @@
+/*
+ * File: tests/clientHarness.cpp
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "clientHarness.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <teamspeak/public_errors.h>
+
+#include "teamspeakPlugin.h"
+#include "protocol.h"
+
+// the plugin library is not linked, its functions are provided here
+struct TS3Functions ts3Functions;
+
+static bool _verbose = false;
+
+static unsigned int logMessage(const char *message, LogLevel severity, const char *, uint64) {
+  if (_verbose || severity <= LogLevel_WARNING) {
+    std::cerr << "[" << severity << "] " << message << std::endl;
+  }
+
+  return ERROR_ok;
+}
+
+static unsigned int freeMemory(void *pointer) {
+  free(pointer);
+  return ERROR_ok;
+}
+
+static unsigned int getServerConnectionHandlerList(uint64 **result) {
+  auto list = (uint64 *)malloc(2 * sizeof(uint64));
+  list[0] = 1;
+  list[1] = 0;
+
+  *result = list;
+  return ERROR_ok;
+}
+
+static unsigned int getServerVariableAsString(uint64, size_t, char **result) {
+  *result = strdup(HARNESS_SERVER_IDENTIFIER);
+  return ERROR_ok;
+}
+
+static unsigned int getConnectionStatus(uint64, int *result) {
+  *result = 1;
+  return ERROR_ok;
+}
+
+static unsigned int getClientID(uint64, anyID *result) {
+  *result = 1;
+  return ERROR_ok;
+}
+
+static unsigned int getChannelOfClient(uint64, anyID, uint64 *result) {
+  *result = HARNESS_CHANNEL_ID;
+  return ERROR_ok;
+}
+
+static unsigned int getChannelVariableAsInt(uint64, uint64, size_t, int *result) {
+  // every channel is subscribed
+  *result = 1;
+  return ERROR_ok;
+}
+
+static unsigned int getChannelClientList(uint64, uint64, anyID **result) {
+  auto list = (anyID *)malloc(2 * sizeof(anyID));
+  list[0] = 1;
+  list[1] = 0;
+
+  *result = list;
+  return ERROR_ok;
+}
+
+static unsigned int getClientSelfVariableAsInt(uint64, size_t, int *result) {
+  // enabled hardware, muted output, no temporary mute while joining
+  *result = 1;
+  return ERROR_ok;
+}
+
+static unsigned int getClientSelfVariableAsString(uint64, size_t, char **result) {
+  *result = strdup(HARNESS_SERVER_IDENTIFIER);
+  return ERROR_ok;
+}
+
+static unsigned int setClientSelfVariableAsInt(uint64, size_t, int) {
+  return ERROR_ok;
+}
+
+static unsigned int setClientSelfVariableAsString(uint64, size_t, const char *) {
+  return ERROR_ok;
+}
+
+static unsigned int flushClientSelfUpdates(uint64, const char *) {
+  return ERROR_ok;
+}
+
+static unsigned int requestClientMove(uint64, anyID, uint64, const char *, const char *) {
+  return ERROR_ok;
+}
+
+static unsigned int requestChannelSubscribe(uint64, const uint64 *, const char *) {
+  return ERROR_ok;
+}
+
+static unsigned int requestMuteClients(uint64, const anyID *, const char *) {
+  return ERROR_ok;
+}
+
+static unsigned int channelset3DAttributes(uint64, anyID, const TS3_VECTOR *) {
+  return ERROR_ok;
+}
+
+static unsigned int systemset3DListenerAttributes(uint64, const TS3_VECTOR *, const TS3_VECTOR *, const TS3_VECTOR *) {
+  return ERROR_ok;
+}
+
+static unsigned int systemset3DSettings(uint64, float, float) {
+  return ERROR_ok;
+}
+
+static void getConfigPath(char *path, size_t maxLen) {
+  snprintf(path, maxLen, "./");
+}
+
+void harness_initTeamspeak(bool verbose) {
+  _verbose = verbose;
+
+  memset(&ts3Functions, 0, sizeof(ts3Functions));
+  ts3Functions.logMessage = logMessage;
+  ts3Functions.freeMemory = freeMemory;
+  ts3Functions.getServerConnectionHandlerList = getServerConnectionHandlerList;
+  ts3Functions.getServerVariableAsString = getServerVariableAsString;
+  ts3Functions.getConnectionStatus = getConnectionStatus;
+  ts3Functions.getClientID = getClientID;
+  ts3Functions.getChannelOfClient = getChannelOfClient;
+  ts3Functions.getChannelVariableAsInt = getChannelVariableAsInt;
+  ts3Functions.getChannelClientList = getChannelClientList;
+  ts3Functions.getClientSelfVariableAsInt = getClientSelfVariableAsInt;
+  ts3Functions.getClientSelfVariableAsString = getClientSelfVariableAsString;
+  ts3Functions.setClientSelfVariableAsInt = setClientSelfVariableAsInt;
+  ts3Functions.setClientSelfVariableAsString = setClientSelfVariableAsString;
+  ts3Functions.flushClientSelfUpdates = flushClientSelfUpdates;
+  ts3Functions.requestClientMove = requestClientMove;
+  ts3Functions.requestChannelSubscribe = requestChannelSubscribe;
+  ts3Functions.requestMuteClients = requestMuteClients;
+  ts3Functions.requestUnmuteClients = requestMuteClients;
+  ts3Functions.channelset3DAttributes = channelset3DAttributes;
+  ts3Functions.systemset3DListenerAttributes = systemset3DListenerAttributes;
+  ts3Functions.systemset3DSettings = systemset3DSettings;
+  ts3Functions.getConfigPath = getConfigPath;
+}
+
+LoopbackServer::LoopbackServer() {
+  _host = nullptr;
+  _peer = nullptr;
+  _thread = nullptr;
+  _running = false;
+
+  _connects = 0;
+  _disconnects = 0;
+  _handshakes = 0;
+  _statusMessages = 0;
+  _kickPending = false;
+  _kickData = 0;
+}
+
+LoopbackServer::~LoopbackServer() {
+  close();
+}
+
+bool LoopbackServer::open() {
+  ENetAddress address;
+  address.port = 0;
+  enet_address_set_host(&address, "127.0.0.1");
+
+  _host = enet_host_create(&address, 1, NETWORK_CHANNELS, 0, 0);
+  if (_host == NULL) {
+    _host = nullptr;
+    return false;
+  }
+
+  _running = true;
+  _thread = new std::thread(&LoopbackServer::update, this);
+
+  return true;
+}
+
+void LoopbackServer::close() {
+  if (_thread != nullptr) {
+    _running = false;
+    _thread->join();
+
+    delete _thread;
+    _thread = nullptr;
+  }
+
+  if (_host != nullptr) {
+    enet_host_destroy(_host);
+    _host = nullptr;
+  }
+}
+
+uint16_t LoopbackServer::port() const {
+  ENetAddress address;
+  if (_host == nullptr || enet_socket_get_address(_host->socket, &address) != 0) {
+    return 0;
+  }
+
+  return address.port;
+}
+
+void LoopbackServer::kick(uint32_t data) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _kickPending = true;
+  _kickData = data;
+}
+
+uint32_t LoopbackServer::connects() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _connects;
+}
+
+uint32_t LoopbackServer::statusMessages() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _statusMessages;
+}
+
+bool LoopbackServer::waitForConnects(uint32_t count, uint32_t timeout) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  return _condition.wait_for(lock, std::chrono::milliseconds(timeout), [this, count]() {
+    return _connects >= count;
+  });
+}
+
+bool LoopbackServer::waitForDisconnects(uint32_t count, uint32_t timeout) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  return _condition.wait_for(lock, std::chrono::milliseconds(timeout), [this, count]() {
+    return _disconnects >= count;
+  });
+}
+
+bool LoopbackServer::waitForStatus(uint32_t count, uint32_t timeout, std::chrono::steady_clock::time_point *receiveTime) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  bool result = _condition.wait_for(lock, std::chrono::milliseconds(timeout), [this, count]() {
+    return _statusMessages >= count;
+  });
+
+  if (result && receiveTime != nullptr) {
+    *receiveTime = _statusTime;
+  }
+
+  return result;
+}
+
+void LoopbackServer::update() {
+  ENetEvent event;
+
+  while (_running) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_kickPending && _peer != nullptr) {
+        enet_peer_disconnect(_peer, _kickData);
+      }
+
+      _kickPending = false;
+    }
+
+    if (enet_host_service(_host, &event, 1) <= 0) {
+      continue;
+    }
+
+    switch (event.type) {
+      case ENET_EVENT_TYPE_CONNECT:
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          _peer = event.peer;
+          _handshakes = 0;
+          _connects++;
+        }
+
+        _condition.notify_all();
+        break;
+
+      case ENET_EVENT_TYPE_DISCONNECT:
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          _peer = nullptr;
+          _disconnects++;
+        }
+
+        _condition.notify_all();
+        break;
+
+      case ENET_EVENT_TYPE_RECEIVE:
+        handleReceive(event);
+        enet_packet_destroy(event.packet);
+        break;
+
+      default:
+        break;
+    }
+  }
+}
+
+void LoopbackServer::handleReceive(ENetEvent &event) {
+  bool result = false;
+
+  if (event.channelID == NETWORK_PROTOCOL_CHANNEL) {
+    // agree on the protocol without optional features, every message keeps its channel
+    protocolResponsePacket_t response;
+    response.statusCode = STATUS_CODE_OK;
+    response.versionMajor = PROTOCOL_VERSION_MAJOR;
+    response.versionMinor = PROTOCOL_VERSION_MINOR;
+    response.capabilities = 0;
+
+    send(serializePacket<protocolResponsePacket_t>(response, &result), NETWORK_PROTOCOL_CHANNEL);
+  } else if (event.channelID == NETWORK_HANDSHAKE_CHANNEL) {
+    // only the first handshake is answered, the second one reports the join
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_handshakes++ > 0) {
+        return;
+      }
+    }
+
+    handshakeResponsePacket_t response;
+    response.statusCode = STATUS_CODE_OK;
+    response.reason = "";
+    response.teamspeakServerUniqueIdentifier = HARNESS_SERVER_IDENTIFIER;
+    response.channelId = HARNESS_CHANNEL_ID;
+    response.channelPassword = "";
+    response.resumptionToken = "harness";
+    response.resumed = false;
+
+    send(serializePacket<handshakeResponsePacket_t>(response, &result), NETWORK_HANDSHAKE_CHANNEL);
+  } else if (event.channelID == NETWORK_STATUS_CHANNEL) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _statusMessages++;
+      _statusTime = std::chrono::steady_clock::now();
+    }
+
+    _condition.notify_all();
+  }
+}
+
+void LoopbackServer::send(ENetPacket *packet, int channelId) {
+  if (packet == nullptr) {
+    std::cerr << "Unable to serialize response on channel " << channelId << std::endl;
+    return;
+  }
+
+  if (_peer == nullptr || enet_peer_send(_peer, (enet_uint8)channelId, packet) != 0) {
+    enet_packet_destroy(packet);
+  }
+}
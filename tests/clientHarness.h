@@ -0,0 +1,91 @@
+/*
+ * File: tests/clientHarness.h
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <enet/enet.h>
+
+#include <stdint.h>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+// channel the mocked teamspeak client is in, the voice server moves it there
+#define HARNESS_CHANNEL_ID 1
+
+// unique identifier of the mocked teamspeak server
+#define HARNESS_SERVER_IDENTIFIER "harness"
+
+// Replaces the teamspeak client functions with mocks of a client already
+// sitting in the in-game channel, so a Client joins without real teamspeak.
+void harness_initTeamspeak(bool verbose);
+
+// Voice server on the loopback interface answering the protocol and
+// handshake messages of a single Client. Serviced on its own thread, which
+// records the arrival of status messages for the latency measurements.
+class LoopbackServer {
+private:
+  ENetHost *_host;
+  ENetPeer *_peer;
+  std::thread *_thread;
+  std::atomic<bool> _running;
+
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  uint32_t _connects;
+  uint32_t _disconnects;
+  uint32_t _handshakes;
+  uint32_t _statusMessages;
+  std::chrono::steady_clock::time_point _statusTime;
+  bool _kickPending;
+  uint32_t _kickData;
+
+public:
+  LoopbackServer();
+  virtual ~LoopbackServer();
+
+  bool open();
+  void close();
+  uint16_t port() const;
+
+  // disconnect the client gracefully with the given disconnect status
+  void kick(uint32_t data);
+
+  uint32_t connects();
+  uint32_t statusMessages();
+  bool waitForConnects(uint32_t count, uint32_t timeout);
+  bool waitForDisconnects(uint32_t count, uint32_t timeout);
+  bool waitForStatus(uint32_t count, uint32_t timeout, std::chrono::steady_clock::time_point *receiveTime);
+
+private:
+  void update();
+  void handleReceive(ENetEvent &event);
+  void send(ENetPacket *packet, int channelId);
+};
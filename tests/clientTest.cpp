@@ -0,0 +1,93 @@
+/*
+ * File: tests/clientTest.cpp
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <stdlib.h>
+#include <enet/enet.h>
+
+#include "client.h"
+#include "config.h"
+#include "clientHarness.h"
+
+// Client tests against a loopback voice server, returning a failure exit
+// code on the first failed check.
+
+#define TEST_TIMEOUT 5000
+
+#define CHECK(condition, message) \
+  if ((condition) == false) { \
+    std::cerr << "FAILED " << __FUNCTION__ << ": " << message << std::endl; \
+    return false; \
+  }
+
+// A server closing an idle session has to end it, not be taken for a lost
+// connection the client resumes. Nothing is sent by the server for longer
+// than the minimum peer timeout before it kicks the client.
+static bool testIdleKick() {
+  LoopbackServer server;
+  CHECK(server.open(), "Unable to open loopback server");
+
+  auto config = config_defaults();
+  config.pingInterval = 100;
+  config.timeoutMinimum = 1000;
+  config.timeoutMaximum = 3000;
+
+  Client client(config);
+  client.connect("127.0.0.1", server.port(), 1);
+  CHECK(client.waitForState(CLIENT_STATE_INGAME, TEST_TIMEOUT), "Client did not join");
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(config.timeoutMinimum + 500));
+
+  server.kick(DISCONNECT_STATUS_OK);
+  CHECK(server.waitForDisconnects(1, TEST_TIMEOUT), "Server did not disconnect the client");
+  CHECK(client.waitForState(CLIENT_STATE_DISCONNECTED, TEST_TIMEOUT), "Client did not close the connection");
+
+  // a misread timeout would reconnect after the reconnect delay
+  std::this_thread::sleep_for(std::chrono::milliseconds(CLIENT_RECONNECT_DELAY * 4));
+  CHECK(server.connects() == 1, "Client reconnected after being kicked");
+  CHECK(client.state() == CLIENT_STATE_DISCONNECTED, "Client is not disconnected");
+
+  return true;
+}
+
+int main(int, char **) {
+  if (enet_initialize() != 0) {
+    std::cerr << "Unable to initialize ENet" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  harness_initTeamspeak(false);
+
+  bool result = testIdleKick();
+
+  enet_deinitialize();
+
+  return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,129 @@
+/*
+ * File: tests/commandQueueTest.cpp
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+
+#include "commandQueue.h"
+
+#define TEST_PRODUCERS 4
+#define TEST_COMMANDS_PER_PRODUCER 100000
+
+#define CHECK(condition, message) \
+  if ((condition) == false) { \
+    std::cerr << "FAILED " << __FUNCTION__ << ": " << message << std::endl; \
+    return false; \
+  }
+
+// Values leave the queue in the order they were pushed, a full queue rejects
+// pushes until the consumer freed a cell, also after wrapping around.
+static bool testOrderAndCapacity() {
+  CommandQueue<int, 4> queue;
+  int value = 0;
+
+  CHECK(queue.pop(value) == false, "Popped from an empty queue");
+
+  for (int lap = 0; lap < 3; lap++) {
+    for (int i = 0; i < 4; i++) {
+      CHECK(queue.push(lap * 10 + i), "Push to a free cell failed");
+    }
+
+    CHECK(queue.push(-1) == false, "Pushed to a full queue");
+
+    CHECK(queue.pop(value) && value == lap * 10, "Unexpected value " << value);
+    CHECK(queue.push(lap * 10 + 4), "Push to a freed cell failed");
+
+    for (int i = 1; i < 5; i++) {
+      CHECK(queue.pop(value) && value == lap * 10 + i, "Unexpected value " << value);
+    }
+
+    CHECK(queue.pop(value) == false, "Popped from an empty queue");
+  }
+
+  return true;
+}
+
+// Several producers push concurrently while a single consumer pops, every
+// value arrives exactly once and in the order of its producer.
+static bool testConcurrentProducers() {
+  CommandQueue<uint32_t, 64> queue;
+  std::vector<std::thread> producers;
+
+  for (uint32_t producer = 0; producer < TEST_PRODUCERS; producer++) {
+    producers.push_back(std::thread([&queue, producer]() {
+      for (uint32_t i = 0; i < TEST_COMMANDS_PER_PRODUCER; i++) {
+        // retry on a full queue like a busy network thread would be waited for
+        while (queue.push((producer << 24) | i) == false) {
+          std::this_thread::yield();
+        }
+      }
+    }));
+  }
+
+  std::vector<uint32_t> next(TEST_PRODUCERS, 0);
+  uint32_t received = 0;
+  bool ordered = true;
+
+  while (received < TEST_PRODUCERS * TEST_COMMANDS_PER_PRODUCER) {
+    uint32_t value;
+    if (queue.pop(value) == false) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    uint32_t producer = value >> 24;
+    uint32_t index = value & 0xffffff;
+
+    if (producer >= TEST_PRODUCERS || index != next[producer]) {
+      ordered = false;
+    } else {
+      next[producer]++;
+    }
+
+    received++;
+  }
+
+  for (auto it = producers.begin(); it != producers.end(); it++) {
+    (*it).join();
+  }
+
+  uint32_t value;
+  CHECK(ordered, "Values of a producer arrived out of order");
+  CHECK(queue.pop(value) == false, "Queue not empty after receiving all values");
+
+  return true;
+}
+
+int main(int, char **) {
+  bool result = testOrderAndCapacity();
+  result = testConcurrentProducers() && result;
+
+  return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,122 @@
+/*
+ * File: tests/configTest.cpp
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "config.h"
+#include "clientHarness.h"
+
+#define TEST_CONFIG_PATH "JustAnotherVoiceChatConfigTest.ini"
+
+#define CHECK(condition, message) \
+  if ((condition) == false) { \
+    std::cerr << "FAILED " << __FUNCTION__ << ": " << message << std::endl; \
+    return false; \
+  }
+
+static bool loadConfig(const std::string &content, clientConfig_t *config) {
+  std::ofstream file(TEST_CONFIG_PATH);
+  file << content;
+  file.close();
+
+  *config = config_defaults();
+  bool result = config_load(TEST_CONFIG_PATH, config);
+
+  remove(TEST_CONFIG_PATH);
+  return result;
+}
+
+static bool testValidValues() {
+  clientConfig_t config;
+  CHECK(loadConfig("[connection]\n# comment\nmtu = 1200\nincoming_bandwidth=4294967295\ntimeout_minimum=2000\ntimeout_maximum=4000\nping_interval=250\nposition_epsilon=0\n", &config), "Unable to load config");
+
+  CHECK(config.mtu == 1200, "Unexpected mtu " << config.mtu);
+  CHECK(config.incomingBandwidth == 4294967295u, "Unexpected bandwidth " << config.incomingBandwidth);
+  CHECK(config.timeoutMinimum == 2000 && config.timeoutMaximum == 4000, "Unexpected timeouts");
+  CHECK(config.pingInterval == 250, "Unexpected ping interval " << config.pingInterval);
+  CHECK(config.positionEpsilon == 0, "Unexpected position epsilon " << config.positionEpsilon);
+
+  return true;
+}
+
+// malformed values and values outside the range of their key keep the defaults
+static bool testInvalidValues() {
+  auto defaults = config_defaults();
+  clientConfig_t config;
+
+  CHECK(loadConfig("mtu=1400x\nincoming_bandwidth=-1\noutgoing_bandwidth=4294967296\nthrottle_interval=+5\nstatus_interval=\nconnect_timeout=0\nposition_epsilon=1001\nunknown_key=1\n", &config), "Unable to load config");
+
+  CHECK(config.mtu == defaults.mtu, "Accepted trailing characters " << config.mtu);
+  CHECK(config.incomingBandwidth == defaults.incomingBandwidth, "Accepted a negative value " << config.incomingBandwidth);
+  CHECK(config.outgoingBandwidth == defaults.outgoingBandwidth, "Accepted an overflowing value " << config.outgoingBandwidth);
+  CHECK(config.throttleInterval == defaults.throttleInterval, "Accepted a sign " << config.throttleInterval);
+  CHECK(config.statusInterval == defaults.statusInterval, "Accepted an empty value " << config.statusInterval);
+  CHECK(config.connectTimeout == defaults.connectTimeout, "Accepted a value below the minimum " << config.connectTimeout);
+  CHECK(config.positionEpsilon == defaults.positionEpsilon, "Accepted a value above the maximum " << config.positionEpsilon);
+
+  CHECK(loadConfig("mtu=100\n", &config) && config.mtu == defaults.mtu, "Accepted an mtu below the ENet minimum " << config.mtu);
+  CHECK(loadConfig("mtu=65536\n", &config) && config.mtu == defaults.mtu, "Accepted an mtu above the ENet maximum " << config.mtu);
+
+  return true;
+}
+
+// timeouts contradicting each other fall back to the defaults together
+static bool testTimeoutChecks() {
+  auto defaults = config_defaults();
+  clientConfig_t config;
+
+  CHECK(loadConfig("timeout_minimum=20000\ntimeout_maximum=5000\n", &config), "Unable to load config");
+  CHECK(config.timeoutMinimum == defaults.timeoutMinimum && config.timeoutMaximum == defaults.timeoutMaximum, "Accepted a minimum above the maximum timeout");
+
+  CHECK(loadConfig("ping_interval=1000\ntimeout_minimum=1000\ntimeout_maximum=5000\n", &config), "Unable to load config");
+  CHECK(config.pingInterval == defaults.pingInterval && config.timeoutMinimum == defaults.timeoutMinimum && config.timeoutMaximum == defaults.timeoutMaximum, "Accepted a ping interval not below the minimum timeout");
+
+  return true;
+}
+
+static bool testMissingFile() {
+  auto config = config_defaults();
+  CHECK(config_load("missing/" TEST_CONFIG_PATH, &config) == false, "Loaded a missing file");
+
+  return true;
+}
+
+int main(int, char **) {
+  harness_initTeamspeak(false);
+
+  bool result = testValidValues();
+  result = testInvalidValues() && result;
+  result = testTimeoutChecks() && result;
+  result = testMissingFile() && result;
+
+  return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
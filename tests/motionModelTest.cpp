@@ -0,0 +1,115 @@
+/*
+ * File: tests/motionModelTest.cpp
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <iostream>
+#include <chrono>
+#include <math.h>
+#include <stdlib.h>
+
+#include "motionModel.h"
+
+#define CHECK(condition, message) \
+  if ((condition) == false) { \
+    std::cerr << "FAILED " << __FUNCTION__ << ": " << message << std::endl; \
+    return false; \
+  }
+
+static clientPosition_t position(float x, float y, float z) {
+  clientPosition_t position;
+  position.x = x;
+  position.y = y;
+  position.z = z;
+
+  return position;
+}
+
+static bool isAt(const clientPosition_t &actual, const clientPosition_t &expected) {
+  return fabs(actual.x - expected.x) < 0.001f && fabs(actual.y - expected.y) < 0.001f && fabs(actual.z - expected.z) < 0.001f;
+}
+
+static motionTime_t after(motionTime_t time, int milliseconds) {
+  return time + std::chrono::milliseconds(milliseconds);
+}
+
+// Moving clients only send samples while they move, so a client which
+// stopped has to end up at its last sample instead of past it.
+static bool testStopAfterMove() {
+  MotionModel model;
+  auto start = std::chrono::steady_clock::now();
+
+  model.addSample(start, position(0, 0, 0));
+  model.addSample(after(start, 50), position(1, 0, 0));
+
+  // interpolated towards the latest sample over one sample interval
+  CHECK(model.isSettled(after(start, 75)) == false, "Settled while interpolating");
+  CHECK(isAt(model.positionAt(after(start, 100)), position(1, 0, 0)), "Latest sample not reached");
+
+  // extrapolated along the last velocity for a short time
+  auto overshoot = model.positionAt(after(start, 100 + MOTION_MAX_EXTRAPOLATION));
+  CHECK(overshoot.x > 1.0f && overshoot.x < 1.0f + 0.02f * MOTION_MAX_EXTRAPOLATION + 0.001f, "Unexpected extrapolation " << overshoot.x);
+
+  auto settled = after(start, 100 + MOTION_MAX_EXTRAPOLATION + MOTION_RETURN_DURATION);
+  CHECK(model.isSettled(settled), "Not settled after returning");
+  CHECK(isAt(model.positionAt(settled), position(1, 0, 0)), "Not returned to the latest sample");
+  CHECK(isAt(model.positionAt(after(settled, 1000)), position(1, 0, 0)), "Moved after settling");
+
+  clientPosition_t rendered;
+  CHECK(model.render(settled, &rendered) && isAt(rendered, position(1, 0, 0)), "Rendered position differs");
+  CHECK(model.render(after(settled, 20), &rendered) == false, "Rendered again while settled");
+
+  return true;
+}
+
+// Teleports and respawns are applied at once, interpolating or extrapolating
+// them would overshoot by the jump distance.
+static bool testTeleport() {
+  MotionModel model;
+  auto start = std::chrono::steady_clock::now();
+
+  model.addSample(start, position(0, 0, 0));
+  model.addSample(after(start, 50), position(1, 0, 0));
+  model.addSample(after(start, 100), position(1000, 0, 50));
+
+  CHECK(isAt(model.positionAt(after(start, 100)), position(1000, 0, 50)), "Jump was smoothed");
+  CHECK(model.isSettled(after(start, 100)), "Not settled after a jump");
+  CHECK(isAt(model.positionAt(after(start, 150)), position(1000, 0, 50)), "Extrapolated a jump");
+
+  // moving on from the new position is smoothed again
+  model.addSample(after(start, 150), position(1001, 0, 50));
+  auto halfway = model.positionAt(after(start, 175));
+  CHECK(halfway.x > 1000.0f && halfway.x < 1001.0f, "Not interpolated after a jump " << halfway.x);
+
+  return true;
+}
+
+int main(int, char **) {
+  bool result = testStopAfterMove();
+  result = testTeleport() && result;
+
+  return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,415 @@
+/*
+ * File: tests/protocolTest.cpp
+ * Date: 17.10.2026
+ *
+ * MIT License
+ *
+ * Copyright (c) 2018 JustAnotherVoiceChat
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <cereal/archives/binary.hpp>
+
+#include "protocol.h"
+
+// Encoding and decoding tests of the network packets, decoding untrusted
+// data has to fail without allocating memory for sizes it claims.
+
+#define CHECK(condition, message) \
+  if ((condition) == false) { \
+    std::cerr << "FAILED " << __FUNCTION__ << ": " << message << std::endl; \
+    return false; \
+  }
+
+template <class T>
+static std::vector<uint8_t> encode(T &packet) {
+  PacketSizeArchive sizeArchive;
+  sizeArchive(packet);
+
+  std::vector<uint8_t> data(sizeArchive.size());
+
+  PacketOutputArchive archive(data.data(), data.size());
+  archive(packet);
+
+  return data;
+}
+
+// append a value in host byte order like cereal's binary archives write it
+template <class T>
+static void append(std::vector<uint8_t> &data, T value) {
+  auto position = data.size();
+  data.resize(position + sizeof(value));
+  memcpy(data.data() + position, &value, sizeof(value));
+}
+
+static void appendBytes(std::vector<uint8_t> &data, size_t count, uint8_t value) {
+  data.insert(data.end(), count, value);
+}
+
+template <class T>
+static bool serializeFails(T &packet) {
+  try {
+    encode(packet);
+  } catch (std::exception &) {
+    return true;
+  }
+
+  return false;
+}
+
+// cereal writes list and string sizes as 64 bit values
+static bool testRejectOversizedList() {
+  std::vector<uint8_t> data;
+  append<uint64_t>(data, PACKET_MAX_ELEMENTS + 1);
+  appendBytes(data, (PACKET_MAX_ELEMENTS + 1) * 7, 0);
+  append<uint64_t>(data, 0);
+
+  bool result = true;
+  deserializePacket<updatePacket_t>(data.data(), data.size(), &result);
+  CHECK(result == false, "Accepted a list above the element limit");
+
+  // a list exactly at the limit is fine
+  data.clear();
+  append<uint64_t>(data, PACKET_MAX_ELEMENTS);
+  appendBytes(data, PACKET_MAX_ELEMENTS * 7, 0);
+  append<uint64_t>(data, 0);
+
+  auto packet = deserializePacket<updatePacket_t>(data.data(), data.size(), &result);
+  CHECK(result && packet.audioUpdates.size() == PACKET_MAX_ELEMENTS, "Rejected a list at the element limit");
+
+  return true;
+}
+
+static bool testRejectListBeyondPacket() {
+  bool result = true;
+
+  // more elements than bytes left, each element takes at least one byte
+  std::vector<uint8_t> data;
+  append<uint64_t>(data, 10);
+  appendBytes(data, 5, 0);
+
+  deserializePacket<updatePacket_t>(data.data(), data.size(), &result);
+  CHECK(result == false, "Accepted a list longer than the packet");
+
+  // sizes which would exhaust the memory if allocated up front
+  data.clear();
+  append<uint64_t>(data, UINT64_MAX);
+
+  deserializePacket<updatePacket_t>(data.data(), data.size(), &result);
+  CHECK(result == false, "Accepted a list of 2^64 elements");
+
+  data.clear();
+  append<uint16_t>(data, 1000);
+  deserializePacket<batchPacket_t>(data.data(), data.size(), &result);
+  CHECK(result == false, "Accepted a batch longer than the packet");
+
+  return true;
+}
+
+static bool testRejectOversizedString() {
+  bool result = true;
+
+  std::vector<uint8_t> data;
+  append<uint64_t>(data, PACKET_MAX_STRING_LENGTH + 1);
+  appendBytes(data, PACKET_MAX_STRING_LENGTH + 1, 'a');
+
+  deserializePacket<controlPacket_t>(data.data(), data.size(), &result);
+  CHECK(result == false, "Accepted a string above the length limit");
+
+  data.clear();
+  append<uint64_t>(data, PACKET_MAX_STRING_LENGTH);
+  appendBytes(data, PACKET_MAX_STRING_LENGTH, 'a');
+
+  auto packet = deserializePacket<controlPacket_t>(data.data(), data.size(), &result);
+  CHECK(result && packet.nickname == std::string(PACKET_MAX_STRING_LENGTH, 'a'), "Rejected a string at the length limit");
+
+  // strings longer than the packet
+  data.clear();
+  append<uint64_t>(data, 100);
+  appendBytes(data, 10, 'a');
+
+  deserializePacket<controlPacket_t>(data.data(), data.size(), &result);
+  CHECK(result == false, "Accepted a string longer than the packet");
+
+  data.clear();
+  append<uint64_t>(data, UINT64_MAX);
+
+  deserializePacket<controlPacket_t>(data.data(), data.size(), &result);
+  CHECK(result == false, "Accepted a string of 2^64 characters");
+
+  return true;
+}
+
+static bool testRoundTrip() {
+  controlPacket_t controlPacket;
+  controlPacket.nickname = "JustAnotherVoiceChat";
+
+  auto data = encode(controlPacket);
+
+  bool result = false;
+  auto decoded = deserializePacket<controlPacket_t>(data.data(), data.size(), &result);
+  CHECK(result && decoded.nickname == controlPacket.nickname, "Control packet changed");
+
+  // truncated packets are rejected
+  deserializePacket<controlPacket_t>(data.data(), data.size() - 1, &result);
+  CHECK(result == false, "Accepted a truncated packet");
+
+  return true;
+}
+
+static positionFramePacket_t makePositionFrame(uint8_t frameType, uint8_t encoding) {
+  positionFramePacket_t packet;
+  packet.frameType = frameType;
+  packet.encoding = encoding;
+  packet.keyframe = 0x1234;
+  packet.scale = 0.0f;
+  packet.x = 100.0f;
+  packet.y = -200.0f;
+  packet.z = 30.0f;
+  packet.rotation = 1.5f;
+
+  for (uint16_t i = 0; i < 3; i++) {
+    packet.teamspeakIds.push_back(i + 10);
+    packet.positionsX.push_back(100.0f + i * 1.25f);
+    packet.positionsY.push_back(-200.0f - i * 2.5f);
+    packet.positionsZ.push_back(30.0f + i * 0.75f);
+    packet.voiceRanges.push_back(10.0f + i);
+  }
+
+  return packet;
+}
+
+static bool isSameFrame(const positionFramePacket_t &actual, const positionFramePacket_t &expected, float tolerance) {
+  if (actual.frameType != expected.frameType || actual.encoding != expected.encoding || actual.keyframe != expected.keyframe) {
+    return false;
+  }
+
+  if (actual.x != expected.x || actual.y != expected.y || actual.z != expected.z || actual.rotation != expected.rotation) {
+    return false;
+  }
+
+  if (actual.teamspeakIds != expected.teamspeakIds || actual.removedIds != expected.removedIds || actual.positionsX.size() != expected.positionsX.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < expected.positionsX.size(); i++) {
+    if (fabs(actual.positionsX[i] - expected.positionsX[i]) > tolerance || fabs(actual.positionsY[i] - expected.positionsY[i]) > tolerance || fabs(actual.positionsZ[i] - expected.positionsZ[i]) > tolerance || fabs(actual.voiceRanges[i] - expected.voiceRanges[i]) > tolerance) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// header, listener and the packed arrays without any per entry overhead
+static bool testPositionFrame() {
+  auto packet = makePositionFrame(POSITION_FRAME_KEYFRAME, POSITION_ENCODING_FLOAT);
+  auto data = encode(packet);
+
+  CHECK(data.size() == 1 + 1 + 2 + 4 * 4 + 2 + 3 * (2 + 4 * 4), "Unexpected frame size " << data.size());
+  CHECK(data[0] == POSITION_FRAME_KEYFRAME && data[1] == POSITION_ENCODING_FLOAT, "Unexpected frame header");
+  CHECK(data[2] == 0x34 && data[3] == 0x12, "Keyframe not in little-endian byte order");
+  CHECK(data[20] == 3 && data[21] == 0 && data[22] == 10 && data[24] == 11 && data[26] == 12, "Unexpected id array");
+
+  bool result = false;
+  auto decoded = deserializePacket<positionFramePacket_t>(data.data(), data.size(), &result);
+  CHECK(result && isSameFrame(decoded, packet, 0.0f), "Frame changed");
+
+  // unknown frame types and encodings are rejected
+  auto invalid = data;
+  invalid[0] = 7;
+  deserializePacket<positionFramePacket_t>(invalid.data(), invalid.size(), &result);
+  CHECK(result == false, "Accepted an unknown frame type");
+
+  invalid = data;
+  invalid[1] = 7;
+  deserializePacket<positionFramePacket_t>(invalid.data(), invalid.size(), &result);
+  CHECK(result == false, "Accepted an unknown encoding");
+
+  deserializePacket<positionFramePacket_t>(data.data(), data.size() - 1, &result);
+  CHECK(result == false, "Accepted a truncated frame");
+
+  // the writer refuses arrays of different sizes
+  packet.positionsY.pop_back();
+  CHECK(serializeFails(packet), "Wrote arrays of different sizes");
+
+  return true;
+}
+
+// delta frames append the ids removed since the keyframe, keyframes never carry any
+static bool testDeltaFrame() {
+  auto packet = makePositionFrame(POSITION_FRAME_DELTA, POSITION_ENCODING_FLOAT);
+  packet.removedIds.push_back(42);
+  packet.removedIds.push_back(43);
+
+  auto data = encode(packet);
+  CHECK(data.size() == 1 + 1 + 2 + 4 * 4 + 2 + 3 * (2 + 4 * 4) + 2 + 2 * 2, "Unexpected frame size " << data.size());
+
+  bool result = false;
+  auto decoded = deserializePacket<positionFramePacket_t>(data.data(), data.size(), &result);
+  CHECK(result && isSameFrame(decoded, packet, 0.0f), "Delta frame changed");
+
+  // only removals, e.g. all moved clients left
+  positionFramePacket_t removals = makePositionFrame(POSITION_FRAME_DELTA, POSITION_ENCODING_FLOAT);
+  removals.teamspeakIds.clear();
+  removals.positionsX.clear();
+  removals.positionsY.clear();
+  removals.positionsZ.clear();
+  removals.voiceRanges.clear();
+  removals.removedIds.push_back(7);
+
+  data = encode(removals);
+  decoded = deserializePacket<positionFramePacket_t>(data.data(), data.size(), &result);
+  CHECK(result && isSameFrame(decoded, removals, 0.0f), "Removal frame changed");
+
+  // the removed ids of keyframes are not written
+  auto keyframe = makePositionFrame(POSITION_FRAME_KEYFRAME, POSITION_ENCODING_FLOAT);
+  keyframe.removedIds.push_back(42);
+
+  data = encode(keyframe);
+  decoded = deserializePacket<positionFramePacket_t>(data.data(), data.size(), &result);
+  CHECK(result && decoded.removedIds.empty(), "Keyframe carried removed ids");
+
+  // removed ids beyond the packet are rejected
+  data = encode(packet);
+  data[data.size() - 2 * 2 - 2] = 0xff;
+  deserializePacket<positionFramePacket_t>(data.data(), data.size(), &result);
+  CHECK(result == false, "Accepted removed ids longer than the packet");
+
+  return true;
+}
+
+// quantized coordinates are offsets to the listener, exact up to half the scale
+static bool testQuantizedFrame() {
+  auto packet = makePositionFrame(POSITION_FRAME_KEYFRAME, POSITION_ENCODING_QUANTIZED);
+  packet.scale = 0.01f;
+
+  auto data = encode(packet);
+  CHECK(data.size() == 1 + 1 + 2 + 4 * 4 + 2 + 3 * 2 + 4 + 3 * (3 * 2 + 2), "Unexpected frame size " << data.size());
+
+  bool result = false;
+  auto decoded = deserializePacket<positionFramePacket_t>(data.data(), data.size(), &result);
+  CHECK(result && decoded.scale == packet.scale, "Quantized frame rejected");
+  CHECK(isSameFrame(decoded, packet, packet.scale / 2 + 0.0001f), "Quantized frame differs by more than half the scale");
+
+  // positions out of the 16 bit range are clamped to its bounds
+  packet.positionsX[0] = packet.x + 1000.0f;
+  packet.positionsX[1] = packet.x - 1000.0f;
+
+  data = encode(packet);
+  decoded = deserializePacket<positionFramePacket_t>(data.data(), data.size(), &result);
+  CHECK(result && fabs(decoded.positionsX[0] - (packet.x + INT16_MAX * packet.scale)) < 0.001f, "Unexpected clamped position " << decoded.positionsX[0]);
+  CHECK(fabs(decoded.positionsX[1] - (packet.x + INT16_MIN * packet.scale)) < 0.001f, "Unexpected clamped position " << decoded.positionsX[1]);
+
+  // frames without a positive scale cannot be written or read
+  packet.scale = 0.0f;
+  CHECK(serializeFails(packet), "Wrote a frame without scale");
+
+  packet.scale = 0.01f;
+  data = encode(packet);
+
+  float scale = -1.0f;
+  memcpy(data.data() + 1 + 1 + 2 + 4 * 4 + 2 + 3 * 2, &scale, sizeof(scale));
+  deserializePacket<positionFramePacket_t>(data.data(), data.size(), &result);
+  CHECK(result == false, "Accepted a negative scale");
+
+  return true;
+}
+
+// messages of a batch are decoded in place from the batch buffer
+static bool testBatch() {
+  statusPacket_t statusPacket;
+  statusPacket.talking = true;
+  statusPacket.microphoneMuted = false;
+  statusPacket.speakersMuted = true;
+
+  controlPacket_t controlPacket;
+  controlPacket.nickname = "batched";
+
+  auto status = encode(statusPacket);
+  auto control = encode(controlPacket);
+
+  batchPacket_t batchPacket;
+
+  batchEntry_t entry;
+  entry.channelId = NETWORK_STATUS_CHANNEL;
+  entry.length = (uint32_t)status.size();
+  entry.data = status.data();
+  batchPacket.entries.push_back(entry);
+
+  entry.channelId = NETWORK_CONTROL_CHANNEL;
+  entry.length = (uint32_t)control.size();
+  entry.data = control.data();
+  batchPacket.entries.push_back(entry);
+
+  auto data = encode(batchPacket);
+  CHECK(data.size() == 2 + (1 + 4) * 2 + status.size() + control.size(), "Unexpected batch size " << data.size());
+
+  bool result = false;
+  auto decoded = deserializePacket<batchPacket_t>(data.data(), data.size(), &result);
+  CHECK(result && decoded.entries.size() == 2, "Batch rejected");
+
+  auto &first = decoded.entries[0];
+  auto &second = decoded.entries[1];
+  CHECK(first.channelId == NETWORK_STATUS_CHANNEL && second.channelId == NETWORK_CONTROL_CHANNEL, "Channels changed");
+  CHECK(first.data >= (const void *)data.data() && second.data < (const void *)(data.data() + data.size()), "Payloads not loaded in place");
+
+  auto decodedStatus = deserializePacket<statusPacket_t>(first.data, first.length, &result);
+  CHECK(result && decodedStatus.talking && decodedStatus.microphoneMuted == false && decodedStatus.speakersMuted, "Batched status changed");
+
+  auto decodedControl = deserializePacket<controlPacket_t>(second.data, second.length, &result);
+  CHECK(result && decodedControl.nickname == controlPacket.nickname, "Batched control changed");
+
+  // payloads longer than the batch are rejected
+  deserializePacket<batchPacket_t>(data.data(), data.size() - 1, &result);
+  CHECK(result == false, "Accepted a truncated batch");
+
+  // more messages than the element limit, even if the bytes are there
+  std::vector<uint8_t> oversized;
+  append<uint16_t>(oversized, PACKET_MAX_ELEMENTS + 1);
+  appendBytes(oversized, (PACKET_MAX_ELEMENTS + 1) * (1 + 4), 0);
+
+  deserializePacket<batchPacket_t>(oversized.data(), oversized.size(), &result);
+  CHECK(result == false, "Accepted a batch above the element limit");
+
+  return true;
+}
+
+int main(int, char **) {
+  bool result = testRejectOversizedList();
+  result = testRejectListBeyondPacket() && result;
+  result = testRejectOversizedString() && result;
+  result = testRoundTrip() && result;
+  result = testPositionFrame() && result;
+  result = testDeltaFrame() && result;
+  result = testQuantizedFrame() && result;
+  result = testBatch() && result;
+
+  return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
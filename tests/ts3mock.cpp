@@ -90,6 +90,10 @@ unsigned int getClientId(uint64, anyID *result) {
   return 0;
 }
 
+void getConfigPath(char *path, size_t maxLen) {
+  snprintf(path, maxLen, "./");
+}
+
 #ifdef _WIN32
 
 #else
@@ -113,6 +117,7 @@ int main(int, char **) {
   functions.destroyServerConnectionHandler = destroyServerConnectionHandler;
   functions.getConnectionStatus = getConnectionStatus;
   functions.getClientID = getClientId;
+  functions.getConfigPath = getConfigPath;
   ts3plugin_setFunctionPointers(functions);
 
   // mockup teamspeak 